@@ -0,0 +1,79 @@
+/* @file ActionKeypad.ino
+|| @version 1.0
+||
+|| @description
+|| | Same behaviour as EventKeypad, but the key handling lives in a table
+|| | in flash instead of a listener full of switch statements. Every
+|| | transition costs one table lookup no matter how many keys are mapped.
+|| #
+*/
+#include <Keypad.h>
+
+const byte ROWS = 4; //four rows
+const byte COLS = 3; //three columns
+char keys[ROWS][COLS] = {
+    {'1','2','3'},
+    {'4','5','6'},
+    {'7','8','9'},
+    {'*','0','#'}
+};
+
+byte rowPins[ROWS] = {5, 4, 3, 2}; //connect to the row pinouts of the keypad
+byte colPins[COLS] = {8, 7, 6}; //connect to the column pinouts of the keypad
+
+Keypad keypad(rowPins, colPins, ROWS, COLS);
+byte ledPin = 13;
+
+boolean blink = false;
+boolean ledPin_state;
+
+void toggleLed(int pin) {
+    digitalWrite(pin, !digitalRead(pin));
+    ledPin_state = digitalRead(pin);        // Remember LED state, lit or unlit.
+}
+
+void setBlink(int on) {
+    if (!on)
+        digitalWrite(ledPin, ledPin_state);    // Restore LED state from before it started blinking.
+    blink = on;
+}
+
+// One row per key code (row * COLS + column), one column per state:
+// IDLE, PRESSED, HOLD, RELEASED.
+const KeypadAction actions[ROWS * COLS][4] PROGMEM = {
+    // Rows 0 to 2 have no actions.
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    // '*' blinks while held and stops when released.
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, {setBlink, true}, {setBlink, false}},
+    // '0'
+    {KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+    // '#' toggles the LED.
+    {KEYPAD_NO_ACTION, {toggleLed, 13}, KEYPAD_NO_ACTION, KEYPAD_NO_ACTION},
+};
+
+void setup(){
+    Serial.begin(9600);
+    pinMode(ledPin, OUTPUT);              // Sets the digital pin as output.
+    digitalWrite(ledPin, HIGH);           // Turn the LED on.
+    ledPin_state = digitalRead(ledPin);   // Store initial LED state. HIGH when LED is on.
+
+    keypad.begin(makeKeymap(keys));
+    keypad.setActionTable(makeActionTable(actions), ROWS * COLS);
+}
+
+void loop(){
+    keypad.getKeys();
+
+    if (blink){
+        digitalWrite(ledPin,!digitalRead(ledPin));    // Change the ledPin from Hi2Lo or Lo2Hi.
+        delay(100);
+    }
+}
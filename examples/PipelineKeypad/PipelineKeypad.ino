@@ -0,0 +1,45 @@
+/* @file PipelineKeypad.ino
+|| @version 1.0
+||
+|| @description
+|| | A directional pad on a matrix without diodes, scanned through a
+|| | pipeline built at compile time: left+right and up+down cancel out,
+|| | ghost keys are masked and every transition goes to onKey().
+|| #
+*/
+#include <Keypad.h>
+#include <KeypadPipeline.h>
+
+const byte ROWS = 3; //three rows
+const byte COLS = 3; //three columns
+char keys[ROWS][COLS] = {
+    {'7','U','9'},
+    {'L','5','R'},
+    {'1','D','3'}
+};
+
+byte rowPins[ROWS] = {5, 4, 3}; //connect to the row pinouts of the keypad
+byte colPins[COLS] = {8, 7, 6}; //connect to the column pinouts of the keypad
+
+KeypadSocdRule socd[] = {
+    KEYPAD_SOCD_RULE(3, 5, KEYPAD_SOCD_NEUTRAL),	// L + R
+    KEYPAD_SOCD_RULE(1, 7, KEYPAD_SOCD_NEUTRAL)		// U + D
+};
+
+Keypad keypad(rowPins, colPins, ROWS, COLS);
+
+void onKey(byte keyCode, KeyState state) {
+    Serial.print(keypad.getKeyChar(keyCode));
+    Serial.println(state == RELEASED ? " up" : state == HOLD ? " held" : " down");
+}
+
+KeypadPipeline<KeypadSocdStage<socd, 2>, KeypadGhostStage, KeypadEventSink<onKey> > pipeline(keypad);
+
+void setup(){
+    Serial.begin(9600);
+    keypad.begin(makeKeymap(keys));
+}
+
+void loop(){
+    pipeline.getKeys();
+}
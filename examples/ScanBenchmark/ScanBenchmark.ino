@@ -0,0 +1,196 @@
+/* @file ScanBenchmark.ino
+|| @version 1.0
+||
+|| @description
+|| | Counts CPU cycles per getKeys() frame for each backend, matrix size
+|| | and scan strategy, and prints one CSV line per combination:
+|| |
+|| |     backend,rows,cols,strategy,min_cycles,avg_cycles
+|| |
+|| | direct-pressed is the direct backend with one key (row 1, column 1)
+|| | wired closed in software, so the probe strategies have to descend.
+|| |
+|| | AVR uses Timer1 at the CPU clock, which simavr models cycle for cycle,
+|| | so AVR numbers can be taken without hardware. extras/bench.sh builds
+|| | this sketch for every board and runs the AVR ones under simavr; on AVR
+|| | the sketch ends by sleeping with interrupts off, which stops simavr.
+|| |
+|| | Cortex-M3/M4/M7 use the DWT cycle counter. Take those on real boards:
+|| | emulators such as QEMU don't count cycles, so their DWT figures mean
+|| | nothing. Other cores fall back to micros() scaled by F_CPU.
+|| #
+*/
+#include <Keypad.h>
+#include <KeypadShiftIn.h>
+#include <KeypadShiftOut.h>
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+#define FRAMES 32
+
+byte rowPins[KEYPAD_MAPSIZE] = {2, 3, 4, 5, 6};
+byte colPins[8] = {7, 8, 9, 10, 11, 12, 14, 15};
+
+// Shift register pins: data, clock, latch.
+#define SR_DATA 16
+#define SR_CLOCK 17
+#define SR_LATCH 18
+
+char keymap[KEYPAD_MAPSIZE * 16];
+
+#if defined(__AVR__)
+volatile uint16_t overflows;
+
+ISR(TIMER1_OVF_vect) {
+    overflows++;
+}
+
+void startCycles() {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);		// No prescaler: one tick per CPU cycle.
+    TIMSK1 = _BV(TOIE1);
+}
+
+uint32_t cycles() {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t lo = TCNT1;
+    uint32_t hi = overflows;
+    if ((TIFR1 & _BV(TOV1)) && lo < 0x8000)
+        hi++;		// Overflow pending but not serviced yet.
+    SREG = sreg;
+    return (hi << 16) | lo;
+}
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+void startCycles() {
+    DEMCR |= 1UL << 24;		// TRCENA
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;
+}
+
+uint32_t cycles() {
+    return DWT_CYCCNT;
+}
+#else
+void startCycles() {}
+
+uint32_t cycles() {
+    return micros() * (F_CPU / 1000000UL);
+}
+#endif
+
+// The direct backend with key (1, 1) closed: column 1 reads LOW while row 1 is
+// driven LOW. The pins are real, the key is only added to what column 1 reads.
+class PressedKeypad: public Keypad {
+public:
+    PressedKeypad(const byte *row, const byte *col, byte numRows, byte numCols):
+            Keypad(row, col, numRows, numCols), rowOutput(false), rowLevel(HIGH) {}
+
+    void pin_mode(byte pinNum, byte mode) {
+        if (pinNum == ::rowPins[1])
+            rowOutput = mode == OUTPUT;
+        Keypad::pin_mode(pinNum, mode);
+    }
+
+    void pin_write(byte pinNum, boolean level) {
+        if (pinNum == ::rowPins[1])
+            rowLevel = level;
+        Keypad::pin_write(pinNum, level);
+    }
+
+    int pin_read(byte pinNum) {
+        int level = Keypad::pin_read(pinNum);
+        if (pinNum == ::colPins[1] && rowOutput && rowLevel == LOW)
+            return LOW;
+        return level;
+    }
+
+private:
+    bool rowOutput;
+    boolean rowLevel;
+};
+
+void report(const char *backend, Keypad &kpd, byte rows, byte cols) {
+    kpd.begin(keymap);
+    kpd.setDebounceTime(1);
+
+    for (byte s=0; s < KEYPAD_SCAN_STRATEGIES; s++) {
+        uint32_t best = 0xFFFFFFFF;
+        uint32_t total = 0;
+
+        kpd.setScanStrategy((KeypadScanStrategy)s);
+        for (byte f=0; f < FRAMES; f++) {
+            delay(2);		// Let the debounce gate open so getKeys() really scans.
+
+            uint32_t t0 = cycles();
+            kpd.getKeys();
+            uint32_t t = cycles() - t0;
+
+            total += t;
+            if (t < best)
+                best = t;
+        }
+
+        Serial.print(backend);
+        Serial.print(',');
+        Serial.print(rows);
+        Serial.print(',');
+        Serial.print(cols);
+        Serial.print(',');
+        Serial.print(s);
+        Serial.print(',');
+        Serial.print(best);
+        Serial.print(',');
+        Serial.println(total / FRAMES);
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    memset(keymap, 'a', sizeof(keymap));
+    startCycles();
+
+    Serial.println("backend,rows,cols,strategy,min_cycles,avg_cycles");
+
+    const byte sizes[][2] = { {4, 3}, {4, 4}, {5, 8} };
+    for (byte i=0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        byte rows = sizes[i][0];
+        byte cols = sizes[i][1];
+
+        Keypad direct(rowPins, colPins, rows, cols);
+        report("direct", direct, rows, cols);
+
+        PressedKeypad pressed(rowPins, colPins, rows, cols);
+        report("direct-pressed", pressed, rows, cols);
+
+        KeypadShiftIn shiftIn(rowPins, rows, cols, SR_DATA, SR_CLOCK, SR_LATCH);
+        report("shiftin", shiftIn, rows, cols);
+
+        KeypadShiftOut shiftOut(colPins, rows, cols, SR_DATA, SR_CLOCK, SR_LATCH);
+        report("shiftout", shiftOut, rows, cols);
+    }
+
+    // Shift register inputs aren't limited by free pins.
+    KeypadShiftIn wide(rowPins, KEYPAD_MAPSIZE, 16, SR_DATA, SR_CLOCK, SR_LATCH);
+    report("shiftin", wide, KEYPAD_MAPSIZE, 16);
+
+    Serial.println("done");
+
+#if defined(__AVR__)
+    // Sleeping with interrupts off is how a simavr run ends.
+    Serial.flush();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    cli();
+    sleep_cpu();
+#endif
+}
+
+void loop() {
+}
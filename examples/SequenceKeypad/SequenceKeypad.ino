@@ -0,0 +1,58 @@
+/* @file SequenceKeypad.ino
+|| @version 1.0
+||
+|| @description
+|| | Watches the typed keys for a few codes. Codes may overlap and are
+|| | recognised wherever they appear; pausing for more than two seconds
+|| | between keys starts over.
+|| |
+|| | sequences.h was generated from sequences.txt with:
+|| |     python3 extras/acgen.py sequences.txt sequences > sequences.h
+|| #
+*/
+#include <Keypad.h>
+#include <KeypadSequence.h>
+#include "sequences.h"
+
+const byte ROWS = 4; //four rows
+const byte COLS = 3; //three columns
+char keys[ROWS][COLS] = {
+    {'1','2','3'},
+    {'4','5','6'},
+    {'7','8','9'},
+    {'*','0','#'}
+};
+
+byte rowPins[ROWS] = {5, 4, 3, 2}; //connect to the row pinouts of the keypad
+byte colPins[COLS] = {8, 7, 6}; //connect to the column pinouts of the keypad
+
+Keypad keypad(rowPins, colPins, ROWS, COLS);
+KeypadSequence codes(keypad, sequences);
+
+void onCode(byte id) {
+    switch (id) {
+        case SEQUENCES_SERVICE:
+            Serial.println("Service menu");
+            break;
+        case SEQUENCES_UNLOCK:
+            Serial.println("Unlocked");
+            break;
+        case SEQUENCES_RESET:
+            Serial.println("Reset");
+            break;
+    }
+}
+
+void setup(){
+    Serial.begin(9600);
+    keypad.begin(makeKeymap(keys));
+    codes.addMatchListener(onCode);
+    codes.setTimeout(2000);
+}
+
+void loop(){
+    char key = keypad.getKey();
+
+    if (key != KEYPAD_NO_KEY)
+        codes.feed(key);
+}
@@ -0,0 +1,25 @@
+// Generated by extras/acgen.py: 3 patterns, 12 states, 253 bytes.
+#include <Arduino.h>
+
+#define SEQUENCES_SERVICE 0	// *#06#
+#define SEQUENCES_UNLOCK 1	// 1379*
+#define SEQUENCES_RESET 2	// *#0#
+
+const uint8_t sequences[] PROGMEM = {
+    0x41, 0x43, 0x01, 0x08, 0x0c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x02, 0x03, 0xff, 0x04, 0xff, 0xff, 0x05, 0x06, 0xff, 0x07, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0x06, 0x00, 0x00, 0x00, 0x00, 0x0b, 0x01, 0x00,
+    0x06, 0x00, 0x04, 0x00, 0x00, 0x05, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x06, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x06, 0x00, 0x00, 0x08, 0x00, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x09, 0x00, 0x0a, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0xff, 0x01,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
@@ -0,0 +1,42 @@
+/* @file StreamKeypad.ino
+|| @version 1.0
+||
+|| @description
+|| | Reads the keypad like a serial port. Type a PIN and finish it with '#'.
+|| | Keys pressed while the sketch is busy are buffered, not lost.
+|| #
+*/
+#include <Keypad.h>
+#include <KeypadStream.h>
+
+const byte ROWS = 4; //four rows
+const byte COLS = 3; //three columns
+char keys[ROWS][COLS] = {
+    {'1','2','3'},
+    {'4','5','6'},
+    {'7','8','9'},
+    {'*','0','#'}
+};
+
+byte rowPins[ROWS] = {5, 4, 3, 2}; //connect to the row pinouts of the keypad
+byte colPins[COLS] = {8, 7, 6}; //connect to the column pinouts of the keypad
+
+Keypad keypad(rowPins, colPins, ROWS, COLS);
+KeypadStream keyStream(keypad);
+
+void setup(){
+    Serial.begin(9600);
+    keypad.begin(makeKeymap(keys));
+    keyStream.setTimeout(10000);          // Give the user 10 seconds per key.
+}
+
+void loop(){
+    char pin[8];
+    size_t len = keyStream.readBytesUntil('#', pin, sizeof(pin) - 1);
+
+    if (len) {
+        pin[len] = '\0';
+        Serial.print("PIN entered: ");
+        Serial.println(pin);
+    }
+}
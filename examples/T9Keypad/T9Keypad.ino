@@ -0,0 +1,68 @@
+/* @file T9Keypad.ino
+|| @version 1.0
+||
+|| @description
+|| | Predictive text entry on a phone keypad. Type a word with one press
+|| | per letter, '*' shows the next candidate, '#' deletes the last digit
+|| | and '0' accepts the word.
+|| |
+|| | dictionary.h was generated from words.txt with:
+|| |     python3 extras/t9dict.py words.txt dictionary > dictionary.h
+|| #
+*/
+#include <Keypad.h>
+#include <KeypadT9.h>
+#include "dictionary.h"
+
+const byte ROWS = 4; //four rows
+const byte COLS = 3; //three columns
+char keys[ROWS][COLS] = {
+    {'1','2','3'},
+    {'4','5','6'},
+    {'7','8','9'},
+    {'*','0','#'}
+};
+
+byte rowPins[ROWS] = {5, 4, 3, 2}; //connect to the row pinouts of the keypad
+byte colPins[COLS] = {8, 7, 6}; //connect to the column pinouts of the keypad
+
+Keypad keypad(rowPins, colPins, ROWS, COLS);
+KeypadT9 t9(dictionary);
+
+void showCandidate() {
+    char word[KEYPAD_T9_MAX_WORD + 1];
+
+    if (t9.candidate(word, sizeof(word)))
+        Serial.println(word);
+}
+
+void setup(){
+    Serial.begin(9600);
+    keypad.begin(makeKeymap(keys));
+}
+
+void loop(){
+    char key = keypad.getKey();
+
+    switch (key) {
+        case KEYPAD_NO_KEY:
+            return;
+        case '*':
+            t9.next();
+            break;
+        case '#':
+            t9.backspace();
+            break;
+        case '0':
+            Serial.print("Accepted: ");
+            showCandidate();
+            t9.reset();
+            return;
+        default:
+            if (!t9.press(key))
+                Serial.println("(no match)");
+            break;
+    }
+
+    showCandidate();
+}
@@ -0,0 +1,20 @@
+// Generated by extras/t9dict.py from words.txt: 31 words, 45 nodes, 236 bytes.
+#include <Arduino.h>
+
+const uint8_t dictionary[] PROGMEM = {
+    0x54, 0x39, 0x01, 0xf5, 0x00, 0x11, 0x00, 0x43, 0x00, 0x7e, 0x00, 0x92, 0x00, 0xc3, 0x00, 0xd5,
+    0x00, 0x11, 0x01, 0x18, 0x00, 0x2b, 0x00, 0x00, 0x08, 0x01, 0x1d, 0x00, 0x02, 0x0a, 0x01, 0x24,
+    0x00, 0x27, 0x00, 0x22, 0x00, 0x01, 0x52, 0x00, 0x02, 0xa2, 0xa1, 0x12, 0x01, 0x32, 0x00, 0x35,
+    0x00, 0x04, 0x00, 0x01, 0x04, 0x0a, 0x01, 0x3c, 0x00, 0x3f, 0x00, 0x0a, 0x00, 0x01, 0x4a, 0x00,
+    0x02, 0x69, 0xaa, 0x72, 0x01, 0x4e, 0x00, 0x66, 0x00, 0x78, 0x00, 0x7b, 0x00, 0x02, 0x08, 0x01,
+    0x53, 0x00, 0x05, 0x28, 0x01, 0x5a, 0x00, 0x63, 0x00, 0x25, 0x10, 0x01, 0x5f, 0x00, 0xa5, 0x00,
+    0x01, 0xa5, 0x02, 0x00, 0x01, 0x25, 0x10, 0x02, 0x6c, 0x00, 0x06, 0x08, 0x02, 0x01, 0x71, 0x00,
+    0x28, 0x00, 0x05, 0x28, 0x49, 0x58, 0x29, 0xa9, 0x00, 0x01, 0x0e, 0x00, 0x01, 0x02, 0x1a, 0x01,
+    0x87, 0x00, 0x8b, 0x00, 0x8e, 0x00, 0x02, 0x00, 0x02, 0x0a, 0x04, 0x00, 0x01, 0x06, 0x00, 0x02,
+    0x09, 0x06, 0x42, 0x01, 0x99, 0x00, 0xa6, 0x00, 0x03, 0x10, 0x01, 0x9e, 0x00, 0x07, 0x02, 0x01,
+    0xa3, 0x00, 0x17, 0x00, 0x01, 0x17, 0x11, 0x01, 0xad, 0x00, 0xbb, 0x00, 0x03, 0x20, 0x01, 0xb2,
+    0x00, 0x03, 0x40, 0x01, 0xb7, 0x00, 0x83, 0x00, 0x01, 0x83, 0x00, 0x20, 0x01, 0xc0, 0x00, 0x23,
+    0x00, 0x01, 0x23, 0x14, 0x01, 0xca, 0x00, 0xd2, 0x00, 0x00, 0x02, 0x01, 0xcf, 0x00, 0x04, 0x00,
+    0x01, 0x14, 0x00, 0x01, 0x08, 0x12, 0x01, 0xdc, 0x00, 0xe4, 0x00, 0x02, 0x20, 0x01, 0xe1, 0x00,
+    0x06, 0x00, 0x01, 0x36, 0x40, 0x01, 0xe9, 0x00, 0x0a, 0x00, 0x01, 0x1a,
+};
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Compile key sequences into a KeypadSequence automaton blob.
+
+Usage: acgen.py PATTERNS.txt NAME > NAME.h
+
+PATTERNS.txt has one "LABEL keys" pair per line, for example
+
+    SERVICE *#06#
+    UNLOCK  1379*
+
+Each label becomes "#define NAME_LABEL id" in the output, the id that the
+match listener receives. All patterns are compiled into one Aho-Corasick
+automaton with every transition resolved, so matching costs one table
+lookup per key.
+
+Blob layout:
+
+    'A' 'C' version
+    keyCount                number of distinct keys
+    stateCount              at most 255, state 0 is the start
+    keyIndex[128]           ASCII key -> column, 0xFF if not in any pattern
+    next[stateCount][keyCount]
+    output[stateCount]      pattern ending in this state, 0xFF for none
+    link[stateCount]        next state down the failure chain with an output, 0 for none
+"""
+import sys
+from collections import deque
+
+VERSION = 1
+
+
+def compile_patterns(patterns):
+    keys = sorted({ch for _, p in patterns for ch in p})
+    index = {ch: i for i, ch in enumerate(keys)}
+
+    goto = [{}]
+    output = [0xFF]
+    for pid, (_, pattern) in enumerate(patterns):
+        state = 0
+        for ch in pattern:
+            if ch not in goto[state]:
+                goto.append({})
+                output.append(0xFF)
+                goto[state][ch] = len(goto) - 1
+            state = goto[state][ch]
+        if output[state] == 0xFF:
+            output[state] = pid
+
+    count = len(goto)
+    if count > 255:
+        sys.exit("too many states (%d), split the patterns" % count)
+
+    fail = [0] * count
+    link = [0] * count
+    nxt = [[0] * len(keys) for _ in range(count)]
+    queue = deque()
+    for ch in keys:
+        s = goto[0].get(ch, 0)
+        nxt[0][index[ch]] = s
+        if s:
+            queue.append(s)
+
+    while queue:
+        state = queue.popleft()
+        f = fail[state]
+        link[state] = f if output[f] != 0xFF else link[f]
+        for ch in keys:
+            s = goto[state].get(ch)
+            if s is None:
+                nxt[state][index[ch]] = nxt[f][index[ch]]
+            else:
+                fail[s] = nxt[f][index[ch]]
+                nxt[state][index[ch]] = s
+                queue.append(s)
+
+    return keys, nxt, output, link
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    path, name = sys.argv[1], sys.argv[2]
+
+    patterns = []
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if not parts:
+                continue
+            if len(parts) != 2:
+                sys.exit("expected 'LABEL keys': %r" % line)
+            if any(ord(ch) > 127 for ch in parts[1]):
+                sys.exit("keys must be ASCII: %r" % line)
+            patterns.append((parts[0], parts[1]))
+    if len(patterns) > 254:
+        sys.exit("at most 254 patterns")
+
+    keys, nxt, output, link = compile_patterns(patterns)
+
+    key_index = [0xFF] * 128
+    for i, ch in enumerate(keys):
+        key_index[ord(ch)] = i
+
+    blob = bytearray(b"AC") + bytes([VERSION, len(keys), len(nxt)])
+    blob += bytes(key_index)
+    for row in nxt:
+        blob += bytes(row)
+    blob += bytes(output) + bytes(link)
+
+    print("// Generated by extras/acgen.py: %d patterns, %d states, %d bytes."
+          % (len(patterns), len(nxt), len(blob)))
+    print("#include <Arduino.h>\n")
+    for pid, (label, pattern) in enumerate(patterns):
+        print("#define %s_%s %d\t// %s" % (name.upper(), label.upper(), pid, pattern))
+    print("\nconst uint8_t %s[] PROGMEM = {" % name)
+    for i in range(0, len(blob), 16):
+        print("    " + ", ".join("0x%02x" % b for b in blob[i:i + 16]) + ",")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
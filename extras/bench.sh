@@ -0,0 +1,58 @@
+#!/bin/sh
+# Build examples/ScanBenchmark for every board and run the AVR builds under simavr,
+# printing cycles per getKeys() frame for each backend, matrix size and strategy:
+#
+#   board,backend,rows,cols,strategy,min_cycles,avg_cycles
+#
+#   extras/bench.sh [board ...]
+#
+# Needs platformio and, to run the AVR boards, simavr. Boards without a cycle
+# accurate simulator (due and other Cortex-M) are only built: QEMU doesn't count
+# cycles, so take their numbers on hardware (see the sketch's header).
+# Exits non-zero if a build fails or a simulated run doesn't reach "done".
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+sketch="$root/examples/ScanBenchmark/ScanBenchmark.ino"
+out="${BENCH_DIR:-$root/_bench}"
+boards=${*:-"uno megaatmega2560 due"}
+status=0
+
+# simavr needs the MCU and clock, the ELF doesn't carry them.
+mcu() {
+    case $1 in
+        uno|nanoatmega328) echo atmega328p ;;
+        megaatmega2560) echo atmega2560 ;;
+        *) echo "" ;;
+    esac
+}
+
+for board in $boards; do
+    dir="$out/$board"
+    mkdir -p "$dir"
+    if ! platformio ci --lib="$root" --board="$board" --keep-build-dir --build-dir="$dir" "$sketch" >"$dir/build.log" 2>&1; then
+        echo "$board: build failed, see $dir/build.log" >&2
+        status=1
+        continue
+    fi
+
+    m=$(mcu "$board")
+    if [ -z "$m" ]; then
+        echo "$board: built, no cycle accurate simulator" >&2
+        continue
+    fi
+
+    # The sketch sleeps with interrupts off once it's done, which ends simavr.
+    # simavr prints each UART line in color, and println() adds a carriage return.
+    timeout 600 simavr -m "$m" -f 16000000 "$dir/.pio/build/$board/firmware.elf" 2>&1 |
+        sed 's/\x1b\[[0-9;]*m//g; s/\r//g' >"$dir/run.log" || true
+    if ! grep -q '^done' "$dir/run.log"; then
+        echo "$board: simulation didn't finish, see $dir/run.log" >&2
+        status=1
+        continue
+    fi
+
+    grep -E '^[a-z-]+,[0-9]+,[0-9]+,[0-9]+,[0-9]+,[0-9]+' "$dir/run.log" | sed "s/^/$board,/"
+done
+
+exit $status
@@ -0,0 +1,152 @@
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+
+// The global pins are a plain table: a pin reads back what was written to it, and
+// INPUT_PULLUP reads HIGH. Nothing in the library depends on more than that.
+static uint8_t pinModes[HOST_PINS];
+static uint8_t pinLevels[HOST_PINS];
+
+HostSerial Serial;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    pinModes[pin] = mode;
+    if (mode == INPUT_PULLUP)
+        pinLevels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    pinLevels[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pinLevels[pin];
+}
+
+static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+size_t Print::write(const char *str) {
+    return str != NULL ? write((const uint8_t *)str, strlen(str)) : 0;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--)
+        n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(unsigned long n, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    if (base < 2)
+        base = 10;
+
+    *str = '\0';
+    do {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return write(str);
+}
+
+size_t Print::print(long n, int base) {
+    if (base == 10 && n < 0)
+        return print('-') + print((unsigned long)-n, 10);
+    return print((unsigned long)n, base);
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0)
+            return c;
+    } while (millis() - start < timeout);
+    return -1;
+}
+
+int Stream::timedPeek() {
+    unsigned long start = millis();
+    do {
+        int c = peek();
+        if (c >= 0)
+            return c;
+    } while (millis() - start < timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0)
+            break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0 || c == terminator)
+            break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+long Stream::parseInt() {
+    bool negative = false;
+    long value = 0;
+    int c;
+
+    do {
+        c = timedPeek();
+        if (c < 0)
+            return 0;
+        if (c == '-' || (c >= '0' && c <= '9'))
+            break;
+        read();
+    } while (true);
+
+    do {
+        if (c == '-')
+            negative = true;
+        else
+            value = value * 10 + c - '0';
+        read();
+        c = timedPeek();
+    } while (c >= '0' && c <= '9');
+
+    return negative ? -value : value;
+}
+
+size_t HostSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
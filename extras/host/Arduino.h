@@ -0,0 +1,105 @@
+// Minimal Arduino core for building the library on a desktop host (Linux, macOS).
+// Only what the library and the host tools in this directory use. Pin functions
+// act on a table of simulated pins (Arduino.cpp); programs that need anything
+// more realistic subclass Keypad and override pin_*() and time_*() instead, see
+// KeypadSim.h.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define memcpy_P memcpy
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+#define noInterrupts()
+#define interrupts()
+
+#define HOST_PINS 256
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const char *str);
+    size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long n, int base = 10);
+    size_t print(unsigned long n, int base = 10);
+    size_t print(int n, int base = 10) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = 10) { return print((unsigned long)n, base); }
+    size_t print(unsigned char n, int base = 10) { return print((unsigned long)n, base); }
+
+    size_t println() { return write("\r\n"); }
+    template<class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template<class T> size_t println(T value, int base) { size_t n = print(value, base); return n + println(); }
+};
+
+class Stream: public Print {
+public:
+    Stream(): timeout(1000) {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+
+    void setTimeout(unsigned long ms) { timeout = ms; }
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    long parseInt();
+
+protected:
+    unsigned long timeout;
+
+    int timedRead();
+    int timedPeek();
+};
+
+// Serial writes to stdout and never has input.
+class HostSerial: public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c);
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,213 @@
+// A Keypad with its own simulated matrix and clock, for running many instances in
+// one host process. Nothing is shared between instances: the pins are a model of
+// the matrix owned by the object, and time_us() is a counter that every pin access
+// advances by a fixed cost, plus whatever the caller adds with advance().
+//
+// Rows are pins 0..rows-1 and columns rows..rows+columns-1. Every key has a diode,
+// so a column reads LOW when any closed key on it sits on a row driven LOW.
+// Contacts bounce for a set time after closing and after opening.
+//
+// measureCurrent() turns on a per-pin state-time accounting model: the time every
+// pin spends as OUTPUT LOW, OUTPUT HIGH, INPUT and INPUT_PULLUP, and the charge
+// drawn through the column pull-ups, one pull-up's current for every column that a
+// closed key holds LOW. Pin states are integrated between pin accesses, delays and
+// advance(), and contacts sampled at each of those. Off by default, it costs a
+// pass over the pins on every access.
+//
+// setPinTrace() works as on hardware, stamped with the simulated clock: modes and
+// writes when the access starts, reads when the level is sampled at its end.
+// build.sh builds with KEYPAD_PIN_TRACE.
+#ifndef KEYPAD_SIM_H
+#define KEYPAD_SIM_H
+
+#include <Keypad.h>
+
+#define KEYPAD_SIM_MAX_ROWS 8
+#define KEYPAD_SIM_MAX_COLS 8
+#define KEYPAD_SIM_MAX_KEYS (KEYPAD_SIM_MAX_ROWS * KEYPAD_SIM_MAX_COLS)
+#define KEYPAD_SIM_MAX_PINS (KEYPAD_SIM_MAX_ROWS + KEYPAD_SIM_MAX_COLS)
+#define KEYPAD_SIM_BOUNCE_STEP 37		// Microseconds between contact chatter samples.
+
+// Pin states for measureCurrent().
+enum KeypadSimPinState {
+    KEYPAD_SIM_OUTPUT_LOW,
+    KEYPAD_SIM_OUTPUT_HIGH,
+    KEYPAD_SIM_INPUT,
+    KEYPAD_SIM_INPUT_PULLUP,
+    KEYPAD_SIM_PIN_STATES
+};
+
+class KeypadSim: public Keypad {
+public:
+    KeypadSim(const byte *row, const byte *col, byte numRows, byte numCols, uint32_t seed, unsigned long pinCost = 4):
+            Keypad(row, col, numRows, numCols) {
+        this->seed = seed;
+        this->pinCost = pinCost;
+        now = 0;
+        pullupMicroamps = 0;
+        for (byte p=0; p < KEYPAD_SIM_MAX_PINS; p++) {
+            modes[p] = INPUT;
+            levels[p] = LOW;
+        }
+        for (byte k=0; k < KEYPAD_SIM_MAX_KEYS; k++)
+            contacts[k].active = false;
+    }
+
+    void pin_mode(byte pinNum, byte mode) {
+        account();
+        traceMode(pinNum, mode);
+        modes[pinNum] = mode;
+        now += pinCost;
+    }
+
+    void pin_write(byte pinNum, boolean level) {
+        account();
+        traceWrite(pinNum, level);
+        levels[pinNum] = level;
+        now += pinCost;
+    }
+
+    int pin_read(byte pinNum) {
+        account();
+        now += pinCost;
+        int level = pulledLow(pinNum - sizeKpd.rows) ? LOW : HIGH;
+        traceRead(pinNum, level);
+        return level;
+    }
+
+    unsigned long time_ms() { return now / 1000; }
+    unsigned long time_us() { return now; }
+
+    void delay_us(uint micros) {
+        account();
+        now += micros;
+    }
+
+    // Time spent outside the library, e.g. the rest of loop().
+    void advance(unsigned long micros) {
+        account();
+        now += micros;
+    }
+
+    // Start (or restart) the current accounting, with pullupMicroamps through each
+    // pull-up that is held LOW. 0 stops it.
+    void measureCurrent(unsigned long pullupMicroamps) {
+        this->pullupMicroamps = pullupMicroamps;
+        measuredFrom = accountedAt = now;
+        charge = 0;
+        for (byte p=0; p < KEYPAD_SIM_MAX_PINS; p++) {
+            for (byte s=0; s < KEYPAD_SIM_PIN_STATES; s++)
+                pinMicros[p][s] = 0;
+        }
+    }
+
+    // Microseconds pin spent in state since measureCurrent().
+    unsigned long long pinTime(byte pin, KeypadSimPinState state) {
+        account();
+        return pinMicros[pin][state];
+    }
+
+    // Average current through the pull-ups since measureCurrent().
+    double averageMicroamps() {
+        account();
+        return now > measuredFrom ? (double)charge / (now - measuredFrom) : 0;
+    }
+
+    // Close keyCode at closeAt and open it again at openAt, both in simulated
+    // microseconds. The contact chatters for bounce after either edge.
+    void press(byte keyCode, unsigned long closeAt, unsigned long openAt, unsigned long bounce) {
+        Contact &k = contacts[keyCode];
+        k.active = true;
+        k.closeAt = closeAt;
+        k.openAt = openAt;
+        k.bounce = bounce;
+    }
+
+    // A key is busy from its press until its release has stopped bouncing.
+    bool busy(byte keyCode) {
+        Contact &k = contacts[keyCode];
+        if (k.active && now >= k.openAt + k.bounce)
+            k.active = false;
+        return k.active;
+    }
+
+    unsigned long closedAt(byte keyCode) { return contacts[keyCode].closeAt; }
+
+private:
+    struct Contact {
+        bool active;
+        unsigned long closeAt;
+        unsigned long openAt;
+        unsigned long bounce;
+    };
+
+    uint32_t seed;
+    unsigned long pinCost;
+    unsigned long now;
+    byte modes[KEYPAD_SIM_MAX_PINS];
+    byte levels[KEYPAD_SIM_MAX_PINS];
+    Contact contacts[KEYPAD_SIM_MAX_KEYS];
+
+    unsigned long pullupMicroamps;
+    unsigned long measuredFrom;
+    unsigned long accountedAt;
+    unsigned long long charge;		// µA times µs.
+    unsigned long long pinMicros[KEYPAD_SIM_MAX_PINS][KEYPAD_SIM_PIN_STATES];
+
+    // Column c reads LOW: a closed key connects it to a row driven LOW.
+    bool pulledLow(byte c) {
+        for (byte r=0; r < sizeKpd.rows; r++) {
+            if (modes[r] == OUTPUT && levels[r] == LOW && closed(r * sizeKpd.columns + c))
+                return true;
+        }
+        return false;
+    }
+
+    KeypadSimPinState pinState(byte pin) {
+        if (modes[pin] == OUTPUT)
+            return levels[pin] ? KEYPAD_SIM_OUTPUT_HIGH : KEYPAD_SIM_OUTPUT_LOW;
+        return modes[pin] == INPUT_PULLUP ? KEYPAD_SIM_INPUT_PULLUP : KEYPAD_SIM_INPUT;
+    }
+
+    // Integrate the pin states and pull-up current from the last access up to now.
+    void account() {
+        if (!pullupMicroamps || now == accountedAt)
+            return;
+
+        unsigned long dt = now - accountedAt;
+        byte pins = sizeKpd.rows + sizeKpd.columns;
+
+        for (byte p=0; p < pins; p++)
+            pinMicros[p][pinState(p)] += dt;
+        for (byte c=0; c < sizeKpd.columns; c++) {
+            if (modes[sizeKpd.rows + c] == INPUT_PULLUP && pulledLow(c))
+                charge += (unsigned long long)dt * pullupMicroamps;
+        }
+        accountedAt = now;
+    }
+
+    bool closed(byte keyCode) {
+        Contact &k = contacts[keyCode];
+
+        if (!k.active || now < k.closeAt)
+            return false;
+        if (now < k.closeAt + k.bounce)
+            return chatter(keyCode);
+        if (now < k.openAt)
+            return true;
+        if (now < k.openAt + k.bounce)
+            return chatter(keyCode);
+        return false;
+    }
+
+    // Deterministic noise, so a run only depends on the seed.
+    bool chatter(byte keyCode) {
+        uint32_t x = seed ^ (keyCode * 0x9E3779B9U) ^ (uint32_t)(now / KEYPAD_SIM_BOUNCE_STEP) * 0x85EBCA6BU;
+        x ^= x >> 16;
+        x *= 0x7FEB352DU;
+        x ^= x >> 15;
+        return x & 1;
+    }
+};
+
+#endif
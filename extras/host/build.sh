@@ -0,0 +1,16 @@
+#!/bin/sh
+# Build a host program against the library and the Arduino shim in this directory.
+#
+#   ./build.sh fleetsim.cpp [extra g++ flags]
+#
+# The binary is written next to the source, without the .cpp.
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+src="$here/../../src"
+prog=$1
+shift
+
+${CXX:-g++} -std=gnu++11 -O2 -Wall -Wextra -pthread -DARDUINO=100 -DKEYPAD_PIN_TRACE=1 -I"$here" -I"$src" \
+    -o "${prog%.cpp}" "$prog" "$here/Arduino.cpp" \
+    "$src"/Keypad*.cpp "$src"/includes/*.cpp "$@"
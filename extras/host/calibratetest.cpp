@@ -0,0 +1,76 @@
+// calibrateScan() against KeypadSim's pin cost clock: every pin access costs the
+// same simulated time, so the cheapest strategy can be worked out by hand.
+//
+//   - open 4x4 matrix: the idle probe is 12 pin accesses against 24 for a full
+//     scan, and bisect costs the same as the probe, so the probe wins the tie
+//   - a key held down: the probe only adds to the full scan, so FULL wins
+//   - a bouncing key: the probes often skip a row that the reference scan sees
+//     closed, so with maxMismatches 0 calibration falls back to FULL, and with
+//     every mismatch allowed the probe wins on cost
+//
+// Build with ./build.sh calibratetest.cpp, run ./calibratetest. Exits non-zero on failure.
+#include "KeypadSim.h"
+
+#include <stdio.h>
+
+#define ROWS 4
+#define COLS 4
+
+static const byte rowPins[ROWS] = {0, 1, 2, 3};
+static const byte colPins[COLS] = {4, 5, 6, 7};
+static const char keys[ROWS * COLS + 1] = "123A456B789C*0#D";
+static const char *names[KEYPAD_SCAN_STRATEGIES] = {"FULL", "IDLE_PROBE", "BISECT"};
+
+static int failures = 0;
+
+static void check(KeypadScanStrategy got, KeypadScanStrategy want, const char *what) {
+    bool ok = got == want;
+    printf("%s %s: %s", ok ? "ok  " : "FAIL", what, names[got]);
+    if (!ok)
+        printf(", expected %s", names[want]);
+    printf("\n");
+    if (!ok)
+        failures++;
+}
+
+int main() {
+    {
+        KeypadSim kpd(rowPins, colPins, ROWS, COLS, 1);
+        kpd.begin(makeKeymap(keys));
+        check(kpd.calibrateScan(8), KEYPAD_SCAN_IDLE_PROBE, "open matrix");
+    }
+
+    {
+        KeypadSim kpd(rowPins, colPins, ROWS, COLS, 1);
+        kpd.begin(makeKeymap(keys));
+        kpd.press(5, 0, 1000000000UL, 0);
+        check(kpd.calibrateScan(8), KEYPAD_SCAN_FULL, "one key held");
+    }
+
+    {
+        // Chatter for the whole calibration, sampled every 37 µs.
+        KeypadSim kpd(rowPins, colPins, ROWS, COLS, 7);
+        kpd.begin(makeKeymap(keys));
+        kpd.press(10, 0, 1000000000UL, 1000000000UL);
+        check(kpd.calibrateScan(16), KEYPAD_SCAN_FULL, "bouncing key, no mismatches allowed");
+    }
+
+    {
+        // Same chatter with every mismatch allowed: the probe is cheaper on average.
+        KeypadSim kpd(rowPins, colPins, ROWS, COLS, 7);
+        kpd.begin(makeKeymap(keys));
+        kpd.press(10, 0, 1000000000UL, 1000000000UL);
+        check(kpd.calibrateScan(16, 16), KEYPAD_SCAN_IDLE_PROBE, "bouncing key, mismatches allowed");
+    }
+
+    {
+        // setCalibration() runs the same selection from begin().
+        KeypadSim kpd(rowPins, colPins, ROWS, COLS, 1);
+        kpd.setCalibration(8);
+        kpd.begin(makeKeymap(keys));
+        check(kpd.calibrateScan(0), KEYPAD_SCAN_IDLE_PROBE, "setCalibration() from begin()");
+    }
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,449 @@
+// Fleet simulator: runs thousands of KeypadSim instances on a work-stealing thread
+// pool and reports aggregate events/sec and press latency, for sizing a gateway
+// that collects input from many remote keypads.
+//
+//   fleetsim [-n instances] [-t threads] [-s seconds] [-w typing|chords|bounce|mixed]
+//            [-r seed] [-l loopMicros] [-v] [-o trace.vcd]
+//
+// Every instance has its own simulated clock and matrix, and its presses come from
+// its own PRNG, so the results depend only on the seed and not on the number of
+// threads or how the instances were scheduled. -v runs the fleet a second time on
+// one thread and checks that. -o writes the pins of instance 0 as a VCD file that
+// GTKWave can open, stamped with its simulated time.
+//
+// Build with ./build.sh fleetsim.cpp
+#include "KeypadSim.h"
+#include <KeypadVcd.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define FLEET_ROWS 4
+#define FLEET_COLS 4
+#define FLEET_KEYS (FLEET_ROWS * FLEET_COLS)
+#define FLEET_SLICE_US 100000UL		// Simulated time an instance runs before going back on a queue.
+#define FLEET_LATENCY_BUCKETS 512	// Latency histogram, 100 µs per bucket.
+#define FLEET_BUCKET_US 100
+
+static const byte rowPins[FLEET_ROWS] = {0, 1, 2, 3};
+static const byte colPins[FLEET_COLS] = {4, 5, 6, 7};
+static const char keys[FLEET_KEYS + 1] = "123A456B789C*0#D";
+static const char *pinNames[FLEET_ROWS + FLEET_COLS] = {"row0", "row1", "row2", "row3", "col0", "col1", "col2", "col3"};
+
+enum Workload {
+    WORKLOAD_TYPING,	// One key at a time, short presses, little bounce.
+    WORKLOAD_CHORDS,	// 2-4 keys together with a few ms of stagger, some long enough to HOLD.
+    WORKLOAD_BOUNCE,	// Like typing, with contacts that chatter for up to 5 ms.
+    WORKLOAD_MIXED,		// Instance i runs workload i % 3.
+    WORKLOADS
+};
+
+static const char *workloadNames[WORKLOADS] = {"typing", "chords", "bounce", "mixed"};
+
+// xorshift32, one per instance.
+struct Rng {
+    uint32_t state;
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    unsigned long range(unsigned long lo, unsigned long hi) { return lo + next() % (hi - lo + 1); }
+};
+
+struct Stats {
+    unsigned long long events;
+    unsigned long long presses;
+    unsigned long long missed;		// Physical presses that never produced PRESSED.
+    unsigned long long polls;		// getKeys() calls.
+    unsigned long long latencySum;
+    unsigned long latencyMax;
+    unsigned long long histogram[FLEET_LATENCY_BUCKETS];
+
+    void clear() { memset(this, 0, sizeof(*this)); }
+
+    void add(const Stats &other) {
+        events += other.events;
+        presses += other.presses;
+        missed += other.missed;
+        polls += other.polls;
+        latencySum += other.latencySum;
+        latencyMax = std::max(latencyMax, other.latencyMax);
+        for (int b=0; b < FLEET_LATENCY_BUCKETS; b++)
+            histogram[b] += other.histogram[b];
+    }
+
+    unsigned long percentile(double p) const {
+        unsigned long long target = (unsigned long long)(p * (presses - missed));
+        unsigned long long seen = 0;
+        for (int b=0; b < FLEET_LATENCY_BUCKETS; b++) {
+            seen += histogram[b];
+            if (seen > target)
+                return (b + 1) * FLEET_BUCKET_US;
+        }
+        return latencyMax;
+    }
+};
+
+// Print to a stdio file, for the VCD trace.
+class FilePrint: public Print {
+public:
+    FilePrint(FILE *file): file(file) {}
+    size_t write(uint8_t c) { return putc(c, file) != EOF; }
+    using Print::write;
+
+private:
+    FILE *file;
+};
+
+// One virtual keypad plus the script that presses its keys.
+class Instance {
+public:
+    Instance(uint32_t seed, Workload workload, unsigned long loopMicros, KeypadVcd *vcd = NULL):
+            kpd(rowPins, colPins, FLEET_ROWS, FLEET_COLS, seed) {
+        this->workload = workload;
+        this->loopMicros = loopMicros;
+        rng.state = seed ? seed : 1;
+        nextBurst = rng.range(0, 200000);
+        for (byte k=0; k < FLEET_KEYS; k++)
+            pending[k] = false;
+        stats.clear();
+
+        // Trace from begin(), so the dump starts with the pins being set up.
+        if (vcd != NULL) {
+            for (byte p=0; p < FLEET_ROWS; p++)
+                vcd->addPin(rowPins[p], pinNames[p]);
+            for (byte p=0; p < FLEET_COLS; p++)
+                vcd->addPin(colPins[p], pinNames[FLEET_ROWS + p]);
+            vcd->begin();
+            kpd.setPinTrace(vcd);
+        }
+        kpd.begin(makeKeymap(keys));
+    }
+
+    // Run until the simulated clock reaches untilMicros.
+    void run(unsigned long untilMicros) {
+        while (kpd.time_us() < untilMicros) {
+            script();
+
+            if (kpd.getKeys())
+                collect();
+            stats.polls++;
+
+            kpd.advance(loopMicros);
+        }
+    }
+
+    // Presses still pending at the end of the run count as missed.
+    void finish() {
+        for (byte k=0; k < FLEET_KEYS; k++)
+            stats.missed += pending[k];
+    }
+
+    Stats stats;
+
+private:
+    KeypadSim kpd;
+    Workload workload;
+    unsigned long loopMicros;
+    Rng rng;
+    unsigned long nextBurst;
+    bool pending[FLEET_KEYS];		// Closed, PRESSED not reported yet.
+
+    void script() {
+        unsigned long now = kpd.time_us();
+        if (now < nextBurst)
+            return;
+
+        switch (workload) {
+            case WORKLOAD_CHORDS: {
+                unsigned long hold = rng.range(100000, 800000);
+                byte count = rng.range(2, 4);
+                for (byte i=0; i < count; i++) {
+                    unsigned long stagger = rng.range(0, 5000);
+                    schedule(rng.range(0, FLEET_KEYS - 1), now + stagger, now + stagger + hold, rng.range(0, 1000));
+                }
+                nextBurst = now + hold + rng.range(200000, 500000);
+                break;
+            }
+            case WORKLOAD_BOUNCE: {
+                unsigned long hold = rng.range(40000, 150000);
+                schedule(rng.range(0, FLEET_KEYS - 1), now, now + hold, rng.range(1000, 5000));
+                nextBurst = now + hold + rng.range(60000, 250000);
+                break;
+            }
+            default: {
+                unsigned long hold = rng.range(40000, 120000);
+                schedule(rng.range(0, FLEET_KEYS - 1), now, now + hold, rng.range(0, 1000));
+                nextBurst = now + hold + rng.range(50000, 250000);
+                break;
+            }
+        }
+    }
+
+    void schedule(byte keyCode, unsigned long closeAt, unsigned long openAt, unsigned long bounce) {
+        // Skip keys whose last press hasn't finished, the script just types something else.
+        if (kpd.busy(keyCode) || pending[keyCode])
+            return;
+
+        kpd.press(keyCode, closeAt, openAt, bounce);
+        pending[keyCode] = true;
+        stats.presses++;
+    }
+
+    void collect() {
+        unsigned long now = kpd.time_us();
+
+        for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
+            if (!kpd.key[i].stateChanged)
+                continue;
+            stats.events++;
+
+            byte keyCode = kpd.key[i].kcode;
+            if (kpd.key[i].kstate != PRESSED || !pending[keyCode])
+                continue;
+
+            unsigned long latency = now - kpd.closedAt(keyCode);
+            pending[keyCode] = false;
+            stats.latencySum += latency;
+            stats.latencyMax = std::max(stats.latencyMax, latency);
+            stats.histogram[std::min(latency / FLEET_BUCKET_US, (unsigned long)FLEET_LATENCY_BUCKETS - 1)]++;
+        }
+    }
+};
+
+// Work-stealing pool: every worker has its own deque of instance indexes, works
+// from the back of it and steals from the front of the others when it runs dry.
+// A task runs one slice of one instance and puts the instance back on the worker's
+// own deque until it reaches the end of the run.
+class Pool {
+public:
+    Pool(std::vector<Instance *> &fleet, unsigned threads, unsigned long endMicros):
+            fleet(fleet), queues(threads), sliceEnd(fleet.size(), 0) {
+        this->endMicros = endMicros;
+        remaining = fleet.size();
+        steals = 0;
+
+        for (size_t i=0; i < fleet.size(); i++)
+            queues[i % threads].tasks.push_back(i);
+    }
+
+    void run() {
+        std::vector<std::thread> workers;
+
+        for (size_t w=0; w < queues.size(); w++)
+            workers.push_back(std::thread(&Pool::worker, this, w));
+        for (size_t w=0; w < workers.size(); w++)
+            workers[w].join();
+    }
+
+    unsigned long long getSteals() { return steals; }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<Instance *> &fleet;
+    std::vector<Queue> queues;
+    std::vector<unsigned long> sliceEnd;
+    unsigned long endMicros;
+    std::atomic<size_t> remaining;
+    std::atomic<unsigned long long> steals;
+
+    bool take(size_t w, size_t &task) {
+        {
+            std::lock_guard<std::mutex> guard(queues[w].lock);
+            if (!queues[w].tasks.empty()) {
+                task = queues[w].tasks.back();
+                queues[w].tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t i=1; i < queues.size(); i++) {
+            Queue &victim = queues[(w + i) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                steals++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void worker(size_t w) {
+        size_t task;
+
+        while (remaining > 0) {
+            if (!take(w, task)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            sliceEnd[task] = std::min(sliceEnd[task] + FLEET_SLICE_US, endMicros);
+            fleet[task]->run(sliceEnd[task]);
+
+            if (sliceEnd[task] < endMicros) {
+                std::lock_guard<std::mutex> guard(queues[w].lock);
+                queues[w].tasks.push_back(task);
+            } else {
+                fleet[task]->finish();
+                remaining--;
+            }
+        }
+    }
+};
+
+struct Options {
+    unsigned instances;
+    unsigned threads;
+    unsigned seconds;
+    Workload workload;
+    uint32_t seed;
+    unsigned long loopMicros;
+    bool verify;
+    const char *vcdPath;
+};
+
+// Build and run a fleet, returning the totals and filling perInstance. Instance 0
+// traces its pins to vcd, if there is one.
+static double runFleet(const Options &opt, unsigned threads, Stats &total, std::vector<Stats> &perInstance,
+        unsigned long long &steals, KeypadVcd *vcd = NULL) {
+    std::vector<Instance *> fleet;
+
+    for (unsigned i=0; i < opt.instances; i++) {
+        Workload w = opt.workload == WORKLOAD_MIXED ? (Workload)(i % WORKLOAD_MIXED) : opt.workload;
+        fleet.push_back(new Instance(opt.seed + i * 0x9E3779B9U, w, opt.loopMicros, i == 0 ? vcd : NULL));
+    }
+
+    Pool pool(fleet, threads, opt.seconds * 1000000UL);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    pool.run();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    steals = pool.getSteals();
+
+    total.clear();
+    perInstance.clear();
+    for (size_t i=0; i < fleet.size(); i++) {
+        total.add(fleet[i]->stats);
+        perInstance.push_back(fleet[i]->stats);
+        delete fleet[i];
+    }
+
+    return wall;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: fleetsim [-n instances] [-t threads] [-s seconds] "
+            "[-w typing|chords|bounce|mixed] [-r seed] [-l loopMicros] [-v] [-o trace.vcd]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    int c;
+
+    opt.instances = 1000;
+    opt.threads = std::max(1U, std::thread::hardware_concurrency());
+    opt.seconds = 10;
+    opt.workload = WORKLOAD_MIXED;
+    opt.seed = 1;
+    opt.loopMicros = 200;
+    opt.verify = false;
+    opt.vcdPath = NULL;
+
+    while ((c = getopt(argc, argv, "n:t:s:w:r:l:vo:")) != -1) {
+        switch (c) {
+            case 'n': opt.instances = atoi(optarg); break;
+            case 't': opt.threads = std::max(1, atoi(optarg)); break;
+            case 's': opt.seconds = atoi(optarg); break;
+            case 'r': opt.seed = strtoul(optarg, NULL, 0); break;
+            case 'l': opt.loopMicros = strtoul(optarg, NULL, 0); break;
+            case 'v': opt.verify = true; break;
+            case 'o': opt.vcdPath = optarg; break;
+            case 'w':
+                for (c=0; c < WORKLOADS && strcmp(optarg, workloadNames[c]); c++) {}
+                if (c == WORKLOADS)
+                    usage();
+                opt.workload = (Workload)c;
+                break;
+            default:
+                usage();
+        }
+    }
+    if (opt.instances == 0 || opt.seconds == 0)
+        usage();
+
+    FILE *vcdFile = NULL;
+    if (opt.vcdPath != NULL && (vcdFile = fopen(opt.vcdPath, "w")) == NULL) {
+        perror(opt.vcdPath);
+        return 1;
+    }
+    FilePrint vcdOut(vcdFile);
+    KeypadVcd vcd(vcdOut);
+
+    Stats total;
+    std::vector<Stats> perInstance;
+    unsigned long long steals;
+    double wall = runFleet(opt, opt.threads, total, perInstance, steals, vcdFile != NULL ? &vcd : NULL);
+    if (vcdFile != NULL)
+        fclose(vcdFile);
+
+    unsigned long worst = 0;
+    double meanWorst = 0;
+    for (size_t i=0; i < perInstance.size(); i++) {
+        worst = std::max(worst, perInstance[i].latencyMax);
+        meanWorst += perInstance[i].latencyMax;
+    }
+    meanWorst /= perInstance.size();
+
+    unsigned long long reported = total.presses - total.missed;
+
+    printf("%u instances (%s), %u threads, %u s simulated each, %.3f s wall\n",
+            opt.instances, workloadNames[opt.workload], opt.threads, opt.seconds, wall);
+    printf("events      %llu (%.0f/s wall, %.1f/s per instance simulated)\n",
+            total.events, total.events / wall, (double)total.events / opt.instances / opt.seconds);
+    printf("polls       %llu (%.0f/s wall)\n", total.polls, total.polls / wall);
+    printf("presses     %llu, %llu reported, %llu missed\n", total.presses, reported, total.missed);
+    printf("latency     mean %.0f us, p50 %lu us, p99 %lu us, max %lu us\n",
+            reported ? (double)total.latencySum / reported : 0.0,
+            total.percentile(0.5), total.percentile(0.99), total.latencyMax);
+    printf("per instance max latency: mean %.0f us, worst %lu us\n", meanWorst, worst);
+    printf("steals      %llu\n", steals);
+
+    if (opt.verify) {
+        Stats single;
+        std::vector<Stats> singleInstance;
+        unsigned long long singleSteals;
+
+        runFleet(opt, 1, single, singleInstance, singleSteals);
+
+        for (size_t i=0; i < perInstance.size(); i++) {
+            if (memcmp(&perInstance[i], &singleInstance[i], sizeof(Stats))) {
+                printf("verify      FAILED: instance %zu differs from the single threaded run\n", i);
+                return 1;
+            }
+        }
+        printf("verify      ok, identical to a single threaded run\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+// KeypadLinuxGpio against a fake GPIO chip, for hosts without gpio-sim or
+// gpio-mockup (or without root to set them up).
+//
+// The fake replaces the ioctl wrappers only. The column line fd is the read end
+// of a non-blocking pipe, and the fake writes a gpio_v2_line_event into it
+// whenever a column falls, so poll(), waitEdge() and drainEdges() run unchanged
+// on a real fd. Rows and columns follow a 4x3 matrix with one diode per key.
+//
+// Build with ./build.sh gpiotest.cpp, run ./gpiotest. Exits non-zero on failure.
+#include <KeypadLinuxGpio.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+
+#include <chrono>
+#include <thread>
+
+#define ROWS 4
+#define COLS 3
+
+static const byte fakeRowLines[ROWS] = {0, 1, 2, 3};
+static const byte fakeColLines[COLS] = {4, 5, 6};
+static const char keys[ROWS * COLS + 1] = "123456789*0#";
+
+class FakeChip: public KeypadLinuxGpio {
+public:
+    FakeChip(): KeypadLinuxGpio("/dev/fake", fakeRowLines, fakeColLines, ROWS, COLS) {
+        rowFd = -1;
+        colFd = -1;
+        edgeFd = -1;
+        rowBits = (1ULL << ROWS) - 1;
+        now = 0;
+        for (byte k=0; k < ROWS * COLS; k++)
+            closed[k] = false;
+    }
+
+    ~FakeChip() {
+        if (edgeFd >= 0)
+            close(edgeFd);
+    }
+
+    unsigned long time_ms() { return now / 1000; }
+    unsigned long time_us() { return now; }
+    void advance(unsigned long micros) { now += micros; }
+
+    // Change a key. A column that falls because of it queues an edge event.
+    void setKey(byte keyCode, bool down) {
+        uint64_t before = columns();
+        closed[keyCode] = down;
+        edges(before, columns());
+    }
+
+    // Queue count edge events as if they had happened earlier.
+    void queueEdges(int count) {
+        for (int i=0; i < count; i++)
+            edge(fakeColLines[i % COLS]);
+    }
+
+    int drain() { return drainEdges(colFd); }
+
+protected:
+    int openChip(const char *) {
+        return open("/dev/null", O_RDWR | O_CLOEXEC);
+    }
+
+    int requestLines(int chipFd, const byte *, byte, uint64_t flags, uint64_t outputs) {
+        if (chipFd < 0)
+            return -1;
+
+        if (flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+            rowBits = outputs;
+            rowFd = open("/dev/null", O_RDWR | O_CLOEXEC);
+            return rowFd;
+        }
+
+        int fds[2];
+        if (pipe(fds) < 0)
+            return -1;
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        if (edgeFd >= 0)
+            close(edgeFd);
+        edgeFd = fds[1];
+        colFd = fds[0];
+        return colFd;
+    }
+
+    bool setValues(int fd, uint64_t bits, uint64_t mask) {
+        if (fd != rowFd)
+            return false;
+
+        uint64_t before = columns();
+        rowBits = (rowBits & ~mask) | (bits & mask);
+        edges(before, columns());
+        return true;
+    }
+
+    bool getValues(int fd, uint64_t mask, uint64_t &bits) {
+        if (fd != colFd)
+            return false;
+        bits = columns() & mask;
+        return true;
+    }
+
+private:
+    int rowFd;
+    int colFd;
+    int edgeFd;
+    uint64_t rowBits;
+    unsigned long now;
+    bool closed[ROWS * COLS];
+
+    // Column levels, HIGH (pulled up) unless a closed key sits on a LOW row.
+    uint64_t columns() {
+        uint64_t bits = (1ULL << COLS) - 1;
+
+        for (byte r=0; r < ROWS; r++) {
+            if (rowBits & (1ULL << r))
+                continue;
+            for (byte c=0; c < COLS; c++) {
+                if (closed[r * COLS + c])
+                    bits &= ~(1ULL << c);
+            }
+        }
+        return bits;
+    }
+
+    void edges(uint64_t before, uint64_t after) {
+        for (byte c=0; c < COLS; c++) {
+            if ((before & (1ULL << c)) && !(after & (1ULL << c)))
+                edge(fakeColLines[c]);
+        }
+    }
+
+    void edge(byte line) {
+        struct gpio_v2_line_event event;
+
+        memset(&event, 0, sizeof(event));
+        event.id = GPIO_V2_LINE_EVENT_FALLING_EDGE;
+        event.offset = line;
+        if (write(edgeFd, &event, sizeof(event)) != sizeof(event))
+            perror("fake edge");
+    }
+};
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static unsigned long waitMillis(FakeChip &kpd, int timeoutMs, bool &activity) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    activity = kpd.waitForActivity(timeoutMs);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Poll getKeys() on the simulated clock, returning the first key that goes PRESSED.
+static char scanFor(FakeChip &kpd, unsigned long millis) {
+    for (unsigned long t=0; t < millis; t++) {
+        kpd.advance(1000);
+        if (!kpd.getKeys())
+            continue;
+        for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
+            if (kpd.key[i].stateChanged && kpd.key[i].kstate == PRESSED)
+                return kpd.key[i].kchar;
+        }
+    }
+    return KEYPAD_NO_KEY;
+}
+
+int main() {
+    FakeChip kpd;
+    bool activity;
+
+    kpd.begin(makeKeymap(keys));
+    check(kpd.isOpen(), "lines requested");
+
+    kpd.setKey(4, true);
+    check(scanFor(kpd, 50) == '5', "scan sees the key on row 1, column 1");
+
+    // Every frame strobes the held key's row, which queues another edge.
+    for (int i=0; i < 50; i++)
+        scanFor(kpd, 11);
+    kpd.setKey(4, false);
+    scanFor(kpd, 50);
+
+    unsigned long took = waitMillis(kpd, 100, activity);
+    check(!activity && took >= 90, "edges left by earlier scans don't end the wait");
+
+    kpd.queueEdges(40);
+    check(kpd.drain() == 40, "drainEdges() reads past the 16 event buffer");
+    check(kpd.drain() == 0, "and leaves nothing behind");
+
+    kpd.setKey(7, true);
+    took = waitMillis(kpd, 1000, activity);
+    check(activity && took < 50, "a key already down returns at once");
+    kpd.setKey(7, false);
+
+    std::thread presser([&kpd]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        kpd.setKey(2, true);
+    });
+    took = waitMillis(kpd, 1000, activity);
+    presser.join();
+    check(activity && took >= 25 && took < 500, "a falling edge ends the wait");
+    kpd.setKey(2, false);
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+// KeypadShm under load from several processes. The parent publishes a KeypadSim as
+// fast as it can scan and restarts its publisher every restartMillis; each forked
+// reader walks the ring and takes snapshots the whole time, then checks that:
+//
+//   - within a generation, the gap between two event indexes is exactly the
+//     events getLostEvents() says it lost, and micros never go back
+//   - key codes and states are valid
+//   - a snapshot's down[] bit is set exactly for keys that are PRESSED or HOLD
+//   - it followed every restart, and once the publisher stops it ends on the
+//     last event of the last generation
+//
+//   shmtest [-r readers] [-s seconds] [-m restartMillis]
+//
+// Build with ./build.sh shmtest.cpp, run ./shmtest. Exits non-zero on failure.
+#include "KeypadSim.h"
+#include <KeypadShm.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#define SHM_ROWS 4
+#define SHM_COLS 4
+#define SHM_KEYS (SHM_ROWS * SHM_COLS)
+#define SHM_MAX_READERS 32
+#define SHM_STUCK_MILLIS 5000		// A reader still running this long after the end is stuck.
+
+static const byte rowPins[SHM_ROWS] = {0, 1, 2, 3};
+static const byte colPins[SHM_COLS] = {4, 5, 6, 7};
+static const char keys[SHM_KEYS + 1] = "123A456B789C*0#D";
+
+struct Result {
+    unsigned long long events;
+    unsigned long long lost;
+    unsigned long long snapshots;
+    unsigned long long torn;		// snapshot() gave up.
+    unsigned long generations;		// Generations the reader saw events from.
+    unsigned long failures;
+    char firstFailure[120];
+};
+
+// Shared with the readers through an anonymous MAP_SHARED mapping.
+struct Control {
+    std::atomic<int> done;
+    std::atomic<uint32_t> generation;	// The publisher's last.
+    std::atomic<uint32_t> head;			// Events in the last generation.
+    Result results[SHM_MAX_READERS];
+};
+
+// Wait for a reader, killing it if it doesn't finish by deadline.
+static bool join(pid_t pid, int &status, std::chrono::steady_clock::time_point deadline) {
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return false;
+        }
+        usleep(1000);
+    }
+    return true;
+}
+
+static void fail(Result &result, const char *what, unsigned long a, unsigned long b) {
+    if (!result.failures++)
+        snprintf(result.firstFailure, sizeof(result.firstFailure), "%s (%lu, %lu)", what, a, b);
+}
+
+class Checker {
+public:
+    Checker(Result &result): result(result), generation(0), index(0), micros(0), lost(0) {}
+
+    void drain(KeypadShmReader &rd) {
+        KeypadShmEvent event;
+
+        while (rd.readEvent(event)) {
+            result.events++;
+
+            if (rd.getGeneration() != generation) {
+                generation = rd.getGeneration();
+                result.generations++;
+            } else {
+                if (event.index - index - 1 != rd.getLostEvents() - lost)
+                    fail(result, "index gap doesn't match the lost count", event.index - index - 1, rd.getLostEvents() - lost);
+                if ((int32_t)(event.micros - micros) < 0)
+                    fail(result, "micros went back", micros, event.micros);
+            }
+
+            if (event.keyCode >= SHM_KEYS)
+                fail(result, "bad key code", event.index, event.keyCode);
+            if (event.state != PRESSED && event.state != HOLD && event.state != RELEASED)
+                fail(result, "bad state", event.index, event.state);
+
+            index = event.index;
+            micros = event.micros;
+            lost = rd.getLostEvents();
+        }
+    }
+
+    void snapshot(KeypadShmReader &rd) {
+        KeyBitmap down;
+        uint8_t states[SHM_KEYS];
+
+        if (!rd.snapshot(down, states)) {
+            result.torn++;
+            return;
+        }
+
+        result.snapshots++;
+        for (byte k=0; k < SHM_KEYS; k++) {
+            if (states[k] > RELEASED)
+                fail(result, "bad snapshot state", k, states[k]);
+            if (down.test(k) != (states[k] == PRESSED || states[k] == HOLD))
+                fail(result, "down[] disagrees with the state", k, states[k]);
+        }
+    }
+
+    uint32_t lastIndex() { return index; }
+    uint32_t lastGeneration() { return generation; }
+
+private:
+    Result &result;
+    uint32_t generation;
+    uint32_t index;
+    uint32_t micros;
+    uint32_t lost;
+};
+
+static void reader(const char *name, Control &control, Result &result) {
+    KeypadShmReader rd(name);
+    Checker checker(result);
+
+    if (!rd.isOpen()) {
+        fail(result, "can't open the segment", 0, 0);
+        return;
+    }
+
+    while (!control.done.load()) {
+        checker.drain(rd);
+        checker.snapshot(rd);
+    }
+    checker.drain(rd);
+    result.lost = rd.getLostEvents();
+
+    uint32_t head = control.head.load();
+    if (rd.getGeneration() != control.generation.load())
+        fail(result, "didn't follow the last restart", rd.getGeneration(), control.generation.load());
+    else if (head && (checker.lastGeneration() != rd.getGeneration() || checker.lastIndex() + 1 != head))
+        fail(result, "didn't reach the last event", checker.lastIndex(), head);
+}
+
+// Press a random idle key now and then, chords and bounce included.
+static void script(KeypadSim &kpd, uint32_t &rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+
+    byte key = rng % SHM_KEYS;
+    if (rng % 4 || kpd.busy(key))
+        return;
+
+    unsigned long now = kpd.time_us();
+    unsigned long closeAt = now + (rng >> 8) % 3000;
+    kpd.press(key, closeAt, closeAt + 20000 + (rng >> 12) % 600000, (rng >> 4) % 3000);
+}
+
+int main(int argc, char **argv) {
+    int readers = 4;
+    int seconds = 3;
+    int restartMillis = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:s:m:")) != -1) {
+        switch (opt) {
+            case 'r': readers = atoi(optarg); break;
+            case 's': seconds = atoi(optarg); break;
+            case 'm': restartMillis = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r readers] [-s seconds] [-m restartMillis]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (readers < 1 || readers > SHM_MAX_READERS || seconds < 1 || restartMillis < 1) {
+        fprintf(stderr, "readers 1-%d, seconds and restartMillis > 0\n", SHM_MAX_READERS);
+        return 2;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "/keypad-shmtest-%d", (int)getpid());
+    shm_unlink(name);
+
+    void *map = mmap(NULL, sizeof(Control), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    Control &control = *new (map) Control();
+
+    KeypadShmPublisher *pub = new KeypadShmPublisher(name, SHM_KEYS);
+    if (!pub->isOpen()) {
+        perror("shm_open");
+        return 1;
+    }
+
+    pid_t pids[SHM_MAX_READERS];
+    for (int i=0; i < readers; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            reader(name, control, control.results[i]);
+            _exit(0);
+        }
+    }
+
+    KeypadSim kpd(rowPins, colPins, SHM_ROWS, SHM_COLS, 1);
+    kpd.begin(makeKeymap(keys));
+    kpd.setDebounceTime(1);
+
+    uint32_t rng = 0x2545F491;
+    uint32_t generation = 1;
+    unsigned long long published = 0;
+    unsigned long head = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point restart = start + std::chrono::milliseconds(restartMillis);
+    std::chrono::steady_clock::time_point end = start + std::chrono::seconds(seconds);
+
+    for (;;) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= end)
+            break;
+
+        if (now >= restart) {
+            delete pub;
+            pub = new KeypadShmPublisher(name, SHM_KEYS);
+            generation++;
+            head = 0;
+            restart = now + std::chrono::milliseconds(restartMillis);
+        }
+
+        for (int i=0; i < 1000; i++) {
+            script(kpd, rng);
+            kpd.advance(500);
+            if (!kpd.getKeys())
+                continue;
+
+            pub->publish(kpd);
+            unsigned long n = kpd.keysPressed.count() + kpd.keysHeld.count() + kpd.keysReleased.count();
+            published += n;
+            head += n;
+        }
+    }
+
+    control.generation.store(generation);
+    control.head.store(head);
+    control.done.store(1);
+
+    int failures = 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(SHM_STUCK_MILLIS);
+    for (int i=0; i < readers; i++) {
+        int status;
+        bool finished = join(pids[i], status, deadline);
+        bool exited = finished && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+        Result &r = control.results[i];
+        printf("reader %d: %llu events, %llu lost, %lu generations, %llu snapshots (%llu torn)\n",
+                i, r.events, r.lost, r.generations, r.snapshots, r.torn);
+        if (r.failures)
+            printf("  FAIL %lu, first: %s\n", r.failures, r.firstFailure);
+        if (!finished)
+            printf("  FAIL stuck, killed\n");
+        else if (!exited)
+            printf("  FAIL exited with status %d\n", status);
+        failures += r.failures || !exited;
+    }
+
+    printf("publisher: %llu events over %u generations\n", published, generation);
+    printf("%s\n", failures ? "FAILED" : "passed");
+
+    delete pub;
+    shm_unlink(name);
+    return failures ? 1 : 0;
+}
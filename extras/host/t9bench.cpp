@@ -0,0 +1,109 @@
+// Times KeypadT9 over a generated dictionary: a depth-first walk presses every digit
+// sequence in the trie, and at every node steps through all its candidates with
+// next(), then back with prev(). Each operation is timed as the difference between
+// a walk that does it and one that only presses and backspaces, averaged over
+// several rounds.
+//
+//   t9bench [-r rounds]
+//
+// The dictionary is the T9Keypad example's. To time another one, generate it with
+// extras/t9dict.py and build with -DT9_DICTIONARY='"path/to/dictionary.h"':
+//
+//   ./build.sh t9bench.cpp -DT9_DICTIONARY='"big.h"'
+#include <KeypadT9.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#ifndef T9_DICTIONARY
+#define T9_DICTIONARY "../../examples/T9Keypad/dictionary.h"
+#endif
+#include T9_DICTIONARY
+
+enum Step { STEP_PRESS, STEP_NEXT, STEP_PREV, STEP_CANDIDATE, STEPS };
+static const char *stepNames[STEPS] = {"press", "next", "prev", "candidate"};
+
+struct Counts {
+    unsigned long nodes;
+    unsigned long candidates;
+    byte maxDepth;
+};
+
+// Visit every node below the current one, doing step at each.
+static void walk(KeypadT9 &t9, Step step, Counts &n) {
+    char word[KEYPAD_T9_MAX_WORD + 1];
+
+    for (char d='2'; d <= '9'; d++) {
+        if (!t9.press(d))
+            continue;
+
+        byte c = t9.candidates();
+        n.nodes++;
+        n.candidates += c;
+        if (t9.length() > n.maxDepth)
+            n.maxDepth = t9.length();
+
+        for (byte i=0; i < c; i++) {
+            if (step == STEP_NEXT)
+                t9.next();
+            else if (step == STEP_PREV)
+                t9.prev();
+            else if (step == STEP_CANDIDATE)
+                t9.candidate(word, sizeof(word));
+        }
+
+        walk(t9, step, n);
+        t9.backspace();
+    }
+}
+
+// Nanoseconds for rounds walks of the whole trie.
+static double timeWalk(Step step, int rounds, Counts &n) {
+    KeypadT9 t9(dictionary);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    for (int r=0; r < rounds; r++) {
+        n.nodes = n.candidates = n.maxDepth = 0;
+        t9.reset();
+        walk(t9, step, n);
+    }
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    int rounds = 1000;
+    int c;
+
+    while ((c = getopt(argc, argv, "r:")) != -1) {
+        switch (c) {
+            case 'r': rounds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r rounds]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (rounds < 1) {
+        fprintf(stderr, "rounds must be > 0\n");
+        return 2;
+    }
+
+    Counts n;
+    double ns[STEPS];
+    for (int s=0; s < STEPS; s++)
+        ns[s] = timeWalk((Step)s, rounds, n);
+
+    printf("%u bytes, %lu nodes, %lu candidates, deepest %d digits, %d rounds\n",
+            (unsigned)sizeof(dictionary), n.nodes, n.candidates, n.maxDepth, rounds);
+    if (!n.nodes)
+        return 1;
+
+    // press() and backspace() come in pairs, so the base walk is timed per press.
+    printf("%-10s %8.1f ns\n", stepNames[STEP_PRESS], ns[STEP_PRESS] / rounds / n.nodes);
+    for (int s=STEP_NEXT; s < STEPS; s++)
+        printf("%-10s %8.1f ns\n", stepNames[s], (ns[s] - ns[STEP_PRESS]) / rounds / n.candidates);
+    return 0;
+}
@@ -0,0 +1,162 @@
+// KeypadTiming against KeypadSim's known press and release times, scanning with
+// setScanRate(2000, 100, 50). Checks that every stamp comes no earlier than its
+// contact edge and no later than getErrorBound() after it, and that dwell and
+// flight times are within getErrorBound() of the scripted ones, bounce included.
+//
+// The first press comes from idle at 10 ms with 3 ms of bounce. While the keypad
+// scans at the idle rate, a scan can sample the contact open in the middle of its
+// bounce and the next one is a whole idle period later, so that press (and its
+// dwell time) is allowed its bounce on top of the bound. Every later press starts
+// within quietMillis of the previous release, at the fast rate.
+//
+//   timingtest [-n presses] [-r seed] [-v]
+//
+// Build with ./build.sh timingtest.cpp, run ./timingtest. Exits non-zero on failure.
+#include "KeypadSim.h"
+#include <KeypadTiming.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ROWS 4
+#define COLS 4
+#define KEYS (ROWS * COLS)
+#define LOOP_MICROS 10
+#define MAX_PRESSES 200
+
+static const byte rowPins[ROWS] = {0, 1, 2, 3};
+static const byte colPins[COLS] = {4, 5, 6, 7};
+static const char keys[KEYS + 1] = "123A456B789C*0#D";
+
+struct Press {
+    byte keyCode;
+    unsigned long closeAt;
+    unsigned long openAt;
+    unsigned long bounce;
+};
+
+static int failures = 0;
+static bool verbose = false;
+
+static void check(bool ok, const char *what, int press, long got, long want, unsigned long slack) {
+    if (verbose || !ok)
+        printf("%s press %d %s: %ld, expected %ld +%lu\n", ok ? "ok  " : "FAIL", press, what, got, want, slack);
+    if (!ok)
+        failures++;
+}
+
+// got must be in [want, want + slack].
+static void late(const char *what, int press, unsigned long got, unsigned long want, unsigned long slack) {
+    check(got >= want && got - want <= slack, what, press, got, want, slack);
+}
+
+// got must be within slack of want either way.
+static void near(const char *what, int press, unsigned long got, unsigned long want, unsigned long slack) {
+    long error = (long)(got - want);
+    check(labs(error) <= (long)slack, what, press, got, want, slack);
+}
+
+// xorshift32
+static uint32_t next(uint32_t &rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+int main(int argc, char **argv) {
+    int presses = 50;
+    uint32_t seed = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:r:v")) != -1) {
+        switch (c) {
+            case 'n': presses = atoi(optarg); break;
+            case 'r': seed = strtoul(optarg, NULL, 0); break;
+            case 'v': verbose = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-n presses] [-r seed] [-v]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (presses < 1 || presses > MAX_PRESSES || !seed) {
+        fprintf(stderr, "presses 1-%d, seed > 0\n", MAX_PRESSES);
+        return 2;
+    }
+
+    KeypadSim kpd(rowPins, colPins, ROWS, COLS, seed);
+    KeypadTiming timing;
+    Press script[MAX_PRESSES];
+    uint32_t rng = seed;
+
+    // One key at a time, each starting 20-40 ms after the last release stops bouncing.
+    unsigned long at = 10000;
+    for (int p=0; p < presses; p++) {
+        script[p].keyCode = p ? next(rng) % KEYS : 5;
+        script[p].closeAt = at;
+        script[p].openAt = at + 40000 + next(rng) % 80000;
+        script[p].bounce = p ? next(rng) % 3001 : 3000;
+        at = script[p].openAt + script[p].bounce + 20000 + next(rng) % 20000;
+    }
+
+    kpd.setTiming(&timing);
+    kpd.begin(makeKeymap(keys));
+    kpd.setScanRate(2000, 100, 50);
+
+    int p = 0;		// Press whose records are expected.
+    int q = 0;		// Next press to hand to the simulator.
+    KeypadTimingRecord pressed = {0, 0, 0, 0};
+    bool havePress = false;
+    unsigned long lastRelease = 0;
+
+    while (p < presses) {
+        if (q < presses && (q == 0 || !kpd.busy(script[q - 1].keyCode))) {
+            kpd.press(script[q].keyCode, script[q].closeAt, script[q].openAt, script[q].bounce);
+            q++;
+        }
+
+        kpd.getKeys();
+        kpd.advance(LOOP_MICROS);
+
+        KeypadTimingRecord record;
+        while (timing.read(record)) {
+            if (record.keyCode != script[p].keyCode) {
+                check(false, "key code", p, record.keyCode, script[p].keyCode, 0);
+                continue;
+            }
+            if (record.edge == PRESSED) {
+                pressed = record;
+                havePress = true;
+                continue;
+            }
+            if (!havePress) {
+                check(false, "RELEASED without PRESSED", p, record.micros, 0, 0);
+                continue;
+            }
+
+            const Press &s = script[p];
+            unsigned long bound = timing.getErrorBound();
+            unsigned long idle = p ? 0 : s.bounce;
+
+            late("press stamp", p, pressed.micros, s.closeAt, bound + idle);
+            late("release stamp", p, record.micros, s.openAt, bound);
+            near("dwell", p, record.interval, s.openAt - s.closeAt, bound + idle);
+            if (p)
+                near("flight", p, pressed.interval, s.closeAt - lastRelease, bound);
+
+            lastRelease = s.openAt;
+            havePress = false;
+            p++;
+        }
+
+        if (p < presses && kpd.time_us() > script[p].openAt + 1000000) {
+            check(false, "no RELEASED record", p, kpd.time_us(), script[p].openAt, 0);
+            break;
+        }
+    }
+
+    printf("%d presses, error bound %lu us\n", p, timing.getErrorBound());
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Build a KeypadT9 dictionary blob from a word list.
+
+Usage: t9dict.py WORDS.txt NAME > NAME.h
+
+WORDS.txt has one word per line, optionally followed by a frequency
+("hello 1200"). Words with characters outside a-z are skipped. More
+frequent words are offered first.
+
+Blob layout (all offsets are 16 bit little endian, from the blob start):
+
+    'T' '9' version
+    node...                     the root node is at offset 3
+
+    node:
+      childMask                 bit i set: there is a child for digit '2' + i
+      wordCount
+      childOffset * popcount(childMask), in digit order
+      word * wordCount          2 bits per letter, the letter's position on
+                                its key, first letter in the low bits; each
+                                word is ceil(depth / 4) bytes
+
+Nodes without complete words get the prefix of their most frequent
+completion, so every reachable node has at least one candidate.
+
+The trie is plain: no two nodes share storage. Suffix sharing doesn't pay
+here, because every node stores its candidates' letters and those differ
+between nodes that end in the same digits. With 16 bit offsets the blob
+tops out at 64 KiB, which is around 5000 English words at 13 bytes a word.
+On AVR a single array can't be larger than 32 KiB (about 2500 words) and
+pgm_read_byte() only reaches the low 64 KiB of flash. The script refuses
+to write a blob that doesn't fit the offsets.
+"""
+import os
+import sys
+
+VERSION = 1
+KEYS = ["abc", "def", "ghi", "jkl", "mno", "pqrs", "tuv", "wxyz"]
+LETTER = {}
+for k, letters in enumerate(KEYS):
+    for i, ch in enumerate(letters):
+        LETTER[ch] = (k, i)
+
+
+class Node:
+    def __init__(self, depth):
+        self.depth = depth
+        self.children = {}
+        self.words = []   # (frequency, word)
+        self.best = None  # most frequent (frequency, word) in the subtree
+        self.offset = 0
+
+
+def build(words):
+    root = Node(0)
+    for freq, word in words:
+        node = root
+        for ch in word:
+            k = LETTER[ch][0]
+            node = node.children.setdefault(k, Node(node.depth + 1))
+        if all(w != word for _, w in node.words):
+            node.words.append((freq, word))
+    return root
+
+
+def finish(node):
+    node.words.sort(key=lambda fw: (-fw[0], fw[1]))
+    best = node.words[0] if node.words else None
+    for child in node.children.values():
+        child_best = finish(child)
+        if child_best and (best is None or child_best[0] > best[0]):
+            best = child_best
+    node.best = best
+    if not node.words and best and node.depth:
+        node.words = [(best[0], best[1][:node.depth])]
+    node.words = node.words[:255]
+    return best
+
+
+def nodes(node):
+    yield node
+    for k in sorted(node.children):
+        yield from nodes(node.children[k])
+
+
+def size(node):
+    return 2 + 2 * len(node.children) + len(node.words) * ((node.depth + 3) // 4)
+
+
+def encode(node):
+    out = bytearray()
+    mask = 0
+    for k in node.children:
+        mask |= 1 << k
+    out += bytes([mask, len(node.words)])
+    for k in sorted(node.children):
+        off = node.children[k].offset
+        out += bytes([off & 0xFF, off >> 8])
+    for _, word in node.words:
+        packed = bytearray((node.depth + 3) // 4)
+        for i, ch in enumerate(word):
+            packed[i // 4] |= LETTER[ch][1] << ((i % 4) * 2)
+        out += packed
+    return out
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    path, name = sys.argv[1], sys.argv[2]
+
+    words = []
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if not parts:
+                continue
+            word = parts[0].lower()
+            if not word or any(ch not in LETTER for ch in word):
+                continue
+            freq = int(parts[1]) if len(parts) > 1 else 0
+            words.append((freq, word))
+
+    root = build(words)
+    finish(root)
+
+    offset = 3
+    order = list(nodes(root))
+    for node in order:
+        node.offset = offset
+        offset += size(node)
+    if offset > 0xFFFF:
+        sys.exit("dictionary too large for 16 bit offsets (%d bytes)" % offset)
+
+    blob = bytearray(b"T9") + bytes([VERSION])
+    for node in order:
+        blob += encode(node)
+
+    print("// Generated by extras/t9dict.py from %s: %d words, %d nodes, %d bytes."
+          % (os.path.basename(path), len(words), len(order), len(blob)))
+    print("#include <Arduino.h>\n")
+    print("const uint8_t %s[] PROGMEM = {" % name)
+    for i in range(0, len(blob), 16):
+        print("    " + ", ".join("0x%02x" % b for b in blob[i:i + 16]) + ",")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
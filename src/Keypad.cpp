@@ -30,6 +30,9 @@
 ||
 */
 #include "Keypad.h"
+#include "KeypadVcd.h"
+#include "KeypadLog.h"
+#include "KeypadTiming.h"
 
 // <<constructor>> Allows custom keymap, pin configuration, and keypad sizes.
 Keypad::Keypad(const byte *row, const byte *col, const byte numRows, const byte numCols): sizeKpd{numRows, numCols} {
@@ -39,49 +42,408 @@ Keypad::Keypad(const byte *row, const byte *col, const byte numRows, const byte
 	setDebounceTime(10);
 	setHoldTime(500);
 	keypadEventListener = 0;
+	keypadStatedEventListener = 0;
+	actionTable = NULL;
+	actionCodes = 0;
+	listenerBudget = 0;
+	pinTrace = NULL;
+	eventLog = NULL;
+	keyTiming = NULL;
+	overrunListener = 0;
+	resetListenerStats();
 
+	keymap = NULL;
+	single_key = false;
+	singleKeyChar = KEYPAD_NO_KEY;
+	holdIdx = 0;
+	holdTimer = 0;
 	startTime = 0;
+	for (byte r=0; r < KEYPAD_MAPSIZE; r++) {
+		bitMap[r] = 0;
+		rawMap[r] = 0;
+		stableMap[r] = 0;
+		rowChangedAt[r] = 0;
+	}
+
+	idleInterval = 0;
+	activeInterval = 0;
+	quietTime = 0;
+	lastScanMicros = 0;
+	lastBusy = 0;
+	scanFast = false;
+	rowsChanged = 0;
+
+	lowPower = false;
+	settleTime = 0;
+	sharedPins = false;
+	interleaveHook = 0;
+
+	wakeLatency = 0;
+	socdRules = NULL;
+	socdCount = 0;
+	scanHook = NULL;
+	scanContext = NULL;
+
+	scanStrategy = KEYPAD_SCAN_FULL;
+	calibrationFrames = 0;
+	calibrationMismatches = 0;
+	for (byte s=0; s < KEYPAD_SCAN_STRATEGIES; s++)
+		scanCost[s] = 0;
+}
+
+void Keypad::pin_mode(byte pinNum, byte mode) {
+    pinMode(pinNum, mode);
+#if KEYPAD_PIN_TRACE
+    traceMode(pinNum, mode);
+#endif
+}
+
+void Keypad::pin_write(byte pinNum, boolean level) {
+    digitalWrite(pinNum, level);
+#if KEYPAD_PIN_TRACE
+    traceWrite(pinNum, level);
+#endif
+}
+
+int Keypad::pin_read(byte pinNum) {
+    int level = digitalRead(pinNum);
+#if KEYPAD_PIN_TRACE
+    traceRead(pinNum, level);
+#endif
+    return level;
+}
+
+void Keypad::traceMode(byte pinNum, byte mode) {
+    if (pinTrace != NULL)
+        pinTrace->mode(pinNum, mode, time_us());
+}
+
+void Keypad::traceWrite(byte pinNum, byte level) {
+    if (pinTrace != NULL)
+        pinTrace->write(pinNum, level, time_us());
+}
+
+void Keypad::traceRead(byte pinNum, byte level) {
+    if (pinTrace != NULL)
+        pinTrace->read(pinNum, level, time_us());
+}
+
+// Record every pin access through pin_mode/pin_write/pin_read into a VCD dump.
+// Returns false if the library was built without KEYPAD_PIN_TRACE. Subclasses that
+// override those functions call traceMode()/traceWrite()/traceRead() themselves.
+bool Keypad::setPinTrace(KeypadVcd *vcd) {
+#if KEYPAD_PIN_TRACE
+    pinTrace = vcd;
+    return true;
+#else
+    return vcd == NULL;
+#endif
+}
+
+// Keep a black-box record of transitions, bounces, dropped keys and listener
+// overruns. See KeypadLog.h.
+void Keypad::setLog(KeypadLog *log) {
+    eventLog = log;
+}
+
+// Stamp press and release edges in microseconds. See KeypadTiming.h.
+void Keypad::setTiming(KeypadTiming *timing) {
+    keyTiming = timing;
 }
 
 // Let the user define a keymap - assume the same row/column count as defined in constructor
 void Keypad::begin(const char *userKeymap) {
     keymap = userKeymap;
-    initRowPins();
-    initColumnPins();
+
+    // Shared pins are only configured for the duration of each scan.
+    if (!sharedPins) {
+        initRowPins();
+        initColumnPins();
+    }
+
+    if (calibrationFrames)
+        calibrateScan(calibrationFrames, calibrationMismatches);
 }
 
 void Keypad::initRowPins() {
     for (byte r=0; r<sizeKpd.rows; r++) {
-        pin_mode(rowPins[r], OUTPUT);
-        pin_write(rowPins[r], HIGH);
+        if (lowPower) {
+            // Tri-stated until strobed. Write LOW first so switching to OUTPUT drives LOW.
+            pin_write(rowPins[r], LOW);
+            pin_mode(rowPins[r], INPUT);
+        } else {
+            pin_mode(rowPins[r], OUTPUT);
+            pin_write(rowPins[r], HIGH);
+        }
     }
 }
 
 void Keypad::initColumnPins() {
+    setColumnPullups(!lowPower);
+}
+
+void Keypad::setColumnPullups(bool enable) {
     for (byte c=0; c<sizeKpd.columns; c++) {
-        pin_mode(columnPins[c], INPUT_PULLUP);
+        pin_mode(columnPins[c], enable ? INPUT_PULLUP : INPUT);
+    }
+}
+
+// Low power scanning: between scans rows are tri-stated and the column pull-ups are
+// off, so a held key draws no current and the pins rest. Pull-ups are only enabled
+// while a scan runs and each strobed row is given settleMicros before it is read.
+// They stay on for the whole frame rather than each strobe: pull-up current only
+// flows through a closed key into a row driven LOW, and between strobes every row is
+// tri-stated, so the gaps cost nothing. Switching them per strobe would add two pin
+// writes per column and row, and columns left floating between strobes would have to
+// charge back up through the pull-up before every read.
+// Each half only applies where the pins are connected directly: KeypadShiftIn still
+// tri-states its rows but leaves the column pull-ups (on the register inputs) to the
+// hardware, and KeypadShiftOut switches its column pull-ups but keeps driving rows
+// through the register.
+void Keypad::setLowPower(bool enable, uint settleMicros) {
+    lowPower = enable;
+    settleTime = settleMicros;
+
+    if (sharedPins)
+        setSharedPins(true);
+    else if (keymap != NULL) {
+        initRowPins();
+        initColumnPins();
     }
 }
 
+// Shared pins: the matrix shares its pins with another peripheral, typically the
+// data bus of an LCD. Every scan saves the pins' modes and levels, configures them
+// for the keypad, scans and puts them back as they were, with a few port register
+// writes. AVR only, and only for matrices on direct pins: returns false and leaves
+// the pins to the keypad otherwise (see KeySharedPins.h).
+bool Keypad::setSharedPins(bool enable) {
+    bool wasShared = sharedPins;
+
+    sharedPins = enable && rowPins != NULL && columnPins != NULL &&
+            sharedPorts.build(rowPins, sizeKpd.rows, columnPins, sizeKpd.columns, lowPower);
+
+    // The pins were only configured during scans, take them over for good.
+    if (wasShared && !sharedPins && keymap != NULL) {
+        initRowPins();
+        initColumnPins();
+    }
+
+    return sharedPins == enable;
+}
+
+// Called between row strobes, with shared pins handed back for the duration, so a
+// display driver can push a transfer without waiting for the whole frame.
+void Keypad::setInterleaveHook(void (*hook)()) {
+    interleaveHook = hook;
+}
+
+// Private : Take the shared pins for a scan.
+void Keypad::claimPins() {
+    sharedPorts.claim();
+    if (pinTrace != NULL)
+        traceSharedPins(true);
+}
+
+// Private : Give the shared pins back after a scan.
+void Keypad::releasePins() {
+    sharedPorts.release();
+    if (pinTrace != NULL)
+        traceSharedPins(false);
+}
+
+// Private : The port writes bypass pin_mode()/pin_write(), so tell the trace what
+// they did.
+void Keypad::traceSharedPins(bool scanning) {
+    byte mode, level;
+
+    for (byte p=0; p < sizeKpd.rows + sizeKpd.columns; p++) {
+        byte pin = p < sizeKpd.rows ? rowPins[p] : columnPins[p - sizeKpd.rows];
+
+        if (!sharedPorts.state(pin, scanning, mode, level))
+            continue;
+        pinTrace->write(pin, level, time_us());
+        pinTrace->mode(pin, mode, time_us());
+    }
+}
+
+// Private : Run the interleave hook between two row strobes.
+void Keypad::interleave() {
+    if (interleaveHook == NULL)
+        return;
+
+    if (sharedPins)
+        releasePins();
+    interleaveHook();
+    if (sharedPins)
+        claimPins();
+}
+
 // Populate the key list.
 bool Keypad::getKeys() {
-	bool keyActivity = false;
+	single_key = false;
+	return scanFrame();
+}
+
+// Backwards compatibility function.
+// Single key mode: returns the key that went PRESSED on this scan or KEYPAD_NO_KEY.
+// Stays in effect until getKeys() is called again.
+char Keypad::getKey() {
+	single_key = true;
+	singleKeyChar = KEYPAD_NO_KEY;
+
+	scanFrame();
+
+	return singleKeyChar;
+}
+
+// Private : Scan and update the list when a scan is due. KeypadGroup, KeypadKeybed
+// and KeypadPipeline run the same steps with their own scan or filters in between.
+bool Keypad::scanFrame() {
+	if (!scanDue())
+		return false;
+
+	scanKeys();
+	bool settling = settleRows(activeInterval != 0);
+	filterFrame();
+	bool keyActivity = commitFrame();
+	updateRate(settling);
+
+	return keyActivity;
+}
 
+// Private : True once per scan period: debounceTime with a fixed rate, the current
+// interval with setScanRate().
+bool Keypad::scanDue() {
 	// Limit how often the keypad is scanned. This makes the loop() run 10 times as fast.
-	if ( (millis()-startTime)>debounceTime ) {
-		scanKeys();
-		keyActivity = updateList();
-		startTime = millis();
-	}
+	if (!activeInterval)
+		return (time_ms()-startTime) > debounceTime;
+
+	unsigned long now = time_us();
+	if (now - lastScanMicros < getScanInterval())
+		return false;
+
+	lastScanMicros = now;
+	return true;
+}
+
+// Private : With debounce, replace the scanned rows with the ones that have been
+// stable for debounceTime. Returns true while a row is still settling.
+bool Keypad::settleRows(bool debounce) {
+	return debounce && debounceRows(time_us());
+}
 
+// Private : Run the state machine on bitMap. Returns true if any key changed state.
+bool Keypad::commitFrame() {
+	bool keyActivity = updateList();
+	startTime = time_ms();
 	return keyActivity;
 }
 
+// Private : True if any key on the list isn't IDLE.
+bool Keypad::listBusy() {
+	for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
+		if (key[i].kchar != KEYPAD_NO_KEY && key[i].kstate != IDLE)
+			return true;
+	}
+	return false;
+}
+
+// Private : Pick the next scan interval. busy keeps the fast rate, as does any key
+// on the list that isn't IDLE. Nothing to do with a fixed rate.
+void Keypad::updateRate(bool busy) {
+	if (!activeInterval)
+		return;
+
+	if (busy || listBusy()) {
+		scanFast = true;
+		lastBusy = startTime;
+	} else if (scanFast && startTime - lastBusy > quietTime) {
+		scanFast = false;
+	}
+}
+
+// Adaptive scan rate: scan every idleMicros while nothing happens and every
+// activeMicros from the first change until quietMillis after the last key is back
+// to IDLE. debounceTime then no longer spaces the scans out. Instead each row must
+// read the same for debounceTime before the change is accepted, so bounce is
+// filtered the same way at either rate and holdTime keeps counting in time_ms().
+// activeMicros = 0 goes back to one scan per debounceTime.
+void Keypad::setScanRate(unsigned long idleMicros, unsigned long activeMicros, uint quietMillis) {
+	idleInterval = idleMicros;
+	activeInterval = activeMicros;
+	quietTime = quietMillis;
+	scanFast = false;
+	rowsChanged = 0;
+
+	for (byte r=0; r < KEYPAD_MAPSIZE; r++) {
+		stableMap[r] = bitMap[r];
+		rowChangedAt[r] = 0;
+	}
+}
+
+// Microseconds until the next scan is due at the current rate, 0 with a fixed rate.
+unsigned long Keypad::getScanInterval() {
+	if (!activeInterval)
+		return 0;
+	return scanFast ? activeInterval : idleInterval;
+}
+
+// Private : Replace the raw rows in bitMap with the ones that have been stable for
+// debounceTime. Returns true while a row is still settling.
+bool Keypad::debounceRows(unsigned long nowMicros) {
+	unsigned long settle = debounceTime * 1000UL;
+	bool settling = false;
+
+	for (byte r=0; r<sizeKpd.rows; r++) {
+		if (bitRead(rowsChanged, r))
+			rowChangedAt[r] = nowMicros;
+
+		if (rawMap[r] != stableMap[r]) {
+			if (nowMicros - rowChangedAt[r] >= settle)
+				stableMap[r] = rawMap[r];
+			else
+				settling = true;
+		}
+
+		bitMap[r] = stableMap[r];
+	}
+
+	rowsChanged = 0;
+	return settling;
+}
+
+// Private : Per-frame stages that rewrite bitMap between the scan and the state machine,
+// so they add no frames of latency.
+void Keypad::filterFrame() {
+	if (socdRules != NULL)
+		keypadResolveSocd(socdRules, socdCount, bitMap, sizeKpd.columns);
+}
+
+// Resolve opposing key pairs (see KeySocd.h) on every scan. The rules array keeps
+// per-pair state, so it must stay in RAM and belong to this keypad.
+void Keypad::setSocdRules(KeypadSocdRule *rules, byte count) {
+	socdRules = rules;
+	socdCount = count;
+}
+
 void Keypad::writeRowPre(byte n) {
+    if (lowPower) {
+        pin_mode(rowPins[n], OUTPUT);		// Already set LOW by initRowPins().
+        if (settleTime)
+            delay_us(settleTime);
+        return;
+    }
+
     pin_write(rowPins[n], LOW);
 }
 
 void Keypad::writeRowPost(byte n) {
+    if (lowPower) {
+        pin_mode(rowPins[n], INPUT);
+        return;
+    }
+
     pin_write(rowPins[n], HIGH);
 }
 
@@ -89,27 +451,221 @@ bool Keypad::readRow(byte n) {
     return !pin_read(columnPins[n]);
 }
 
-// Private : Hardware scan
-void Keypad::scanKeys() {
+// Drive every row in rowMask at once and release the others.
+// Backends that can't address rows one pin at a time should override this.
+void Keypad::driveRows(uint rowMask) {
+    for (byte r=0; r<sizeKpd.rows; r++) {
+        if (bitRead(rowMask, r))
+            writeRowPre(r);
+        else
+            writeRowPost(r);
+    }
+}
+
+// Read all the columns of whatever rows are currently driven.
+uint Keypad::readColumns() {
+    uint cols = 0;
+
+    for (byte c=0; c<sizeKpd.columns; c++) {
+        if (readRow(c))
+            cols |= 1U << c;
+    }
+
+    return cols;
+}
+
+// Private : Hardware scan. The hook, if any, is called at every column read, see
+// KeypadScanHook.
+void Keypad::scanKeys(KeypadScanHook hook, void *context) {
+    beginScan();
+
+    scanHook = hook;
+    scanContext = context;
+    scanMatrix();
+    scanHook = NULL;
+
+    endScan();
+}
+
+// Private : Get the pins ready for a scan. Split from scanKeys() for matrices that
+// are read along with another one's rows (KeypadGroup).
+void Keypad::beginScan() {
+    if (keyTiming != NULL)
+        keyTiming->frame(time_us());
+
+    // Shared pins are claimed with the column pull-ups already on.
+    if (sharedPins)
+        claimPins();
+    else if (lowPower && columnPins != NULL)
+        setColumnPullups(true);
+}
+
+void Keypad::endScan() {
+    if (sharedPins)
+        releasePins();
+    else if (lowPower && columnPins != NULL)
+        setColumnPullups(false);
+}
+
+void Keypad::scanMatrix() {
+    // Probe all rows with a single strobe. An open matrix is the common case
+    // and costs one column read instead of one per row.
+    if (scanStrategy != KEYPAD_SCAN_FULL) {
+        if (!scanProbe(rowBits(sizeKpd.rows)))
+            return;
+
+        if (scanStrategy == KEYPAD_SCAN_BISECT && sizeKpd.rows > 1) {
+            scanRowRange(0, sizeKpd.rows / 2);
+            interleave();
+            scanRowRange(sizeKpd.rows / 2, sizeKpd.rows - sizeKpd.rows / 2);
+            return;
+        }
+    }
+
 	// bitMap stores ALL the keys that are being pressed.
 	for (byte r=0; r<sizeKpd.rows; r++) {
-        // Begin column pulse output.
-        writeRowPre(r);
+        scanRow(r);
 
-		for (byte c=0; c<sizeKpd.columns; c++) {
-            bitWrite(bitMap[r], c, readRow(c));
-		}
-
-		// End column pulse.
-        writeRowPost(r);
+        if (r + 1 < sizeKpd.rows)
+            interleave();
 	}
 }
 
+// Strobe a group of rows together and only descend into the halves that see a key.
+void Keypad::scanRowRange(byte first, byte count) {
+    if (count == 1) {
+        scanRow(first);
+        return;
+    }
+
+    if (!scanProbe(rowBits(count) << first))
+        return;
+
+    scanRowRange(first, count / 2);
+    scanRowRange(first + count / 2, count - count / 2);
+}
+
+// Private : The low count bits set. count may be the full width of uint (16 rows on
+// AVR), where 1U << count would be undefined.
+uint Keypad::rowBits(byte count) {
+    return count ? (uint)~0U >> (8 * sizeof(uint) - count) : 0;
+}
+
+// Private : Drive the rows in rowMask together. If no column (and nothing the scan
+// hook reads) is active, store them all as open and return false.
+bool Keypad::scanProbe(uint rowMask) {
+    driveRows(rowMask);
+    uint cols = readColumns();
+    bool seen = scanHook != NULL && scanHook(scanContext, rowMask, true);
+    driveRows(0);
+
+    if (cols || seen)
+        return true;
+
+    for (byte r=0; r<sizeKpd.rows; r++) {
+        if (bitRead(rowMask, r))
+            storeRow(r, 0);
+    }
+    if (scanHook != NULL)
+        scanHook(scanContext, rowMask, false);
+    return false;
+}
+
+// Private : Strobe a single row and store it.
+void Keypad::scanRow(byte r) {
+    // Begin column pulse output.
+    writeRowPre(r);
+
+    storeRow(r, readColumns());
+    if (scanHook != NULL)
+        scanHook(scanContext, 1U << r, true);
+
+    // End column pulse.
+    writeRowPost(r);
+}
+
+// Private : Save a scanned row word. Changes are detected against the previous raw
+// scan, so filters and debouncing that rewrite bitMap don't look like edges.
+void Keypad::storeRow(byte r, uint cols) {
+    if (cols != rawMap[r]) {
+        if (keyTiming != NULL)
+            keyTiming->rowChanged(r * sizeKpd.columns, cols ^ rawMap[r], cols, time_us(), debounceTime * 1000UL);
+        rawMap[r] = cols;
+        rowsChanged |= 1U << r;
+    }
+    bitMap[r] = cols;
+}
+
+// Time every scan strategy for a few frames on the real pins and keep the fastest
+// one whose bitmaps match a full scan in no more than maxMismatches frames.
+// Timing goes through time_us() so a host emulator can substitute a cost model.
+KeypadScanStrategy Keypad::calibrateScan(byte frames, byte maxMismatches) {
+    if (frames == 0)
+        return scanStrategy;
+
+    uint reference[KEYPAD_MAPSIZE];
+    KeypadScanStrategy chosen = KEYPAD_SCAN_FULL;
+    unsigned long best = 0;
+
+    for (byte s=0; s < KEYPAD_SCAN_STRATEGIES; s++) {
+        unsigned long total = 0;
+        byte mismatches = 0;
+
+        for (byte f=0; f < frames; f++) {
+            scanStrategy = KEYPAD_SCAN_FULL;
+            scanKeys();
+            memcpy(reference, bitMap, sizeof(reference));
+
+            scanStrategy = (KeypadScanStrategy)s;
+            unsigned long t0 = time_us();
+            scanKeys();
+            total += time_us() - t0;
+
+            if (memcmp(reference, bitMap, sizeKpd.rows * sizeof(uint)))
+                mismatches++;
+        }
+
+        scanCost[s] = total / frames;
+        if (mismatches <= maxMismatches && (s == KEYPAD_SCAN_FULL || scanCost[s] < best)) {
+            chosen = (KeypadScanStrategy)s;
+            best = scanCost[s];
+        }
+    }
+
+    scanStrategy = chosen;
+    return chosen;
+}
+
+// Run calibrateScan() from begin(). Zero frames (the default) keeps the current strategy.
+void Keypad::setCalibration(byte frames, byte maxMismatches) {
+    calibrationFrames = frames;
+    calibrationMismatches = maxMismatches;
+}
+
+// Override the strategy picked by calibration.
+void Keypad::setScanStrategy(KeypadScanStrategy strategy) {
+    if (strategy < KEYPAD_SCAN_STRATEGIES)
+        scanStrategy = strategy;
+}
+
+KeypadScanStrategy Keypad::getScanStrategy() {
+    return scanStrategy;
+}
+
+// Average microseconds per scan measured by the last calibration, 0 if never run.
+unsigned long Keypad::getScanCost(KeypadScanStrategy strategy) {
+    return strategy < KEYPAD_SCAN_STRATEGIES ? scanCost[strategy] : 0;
+}
+
 // Manage the list without rearranging the keys. Returns true if any keys on the list changed state.
 bool Keypad::updateList() {
 
 	byte emptyPos = 0xFF;
 
+	keysPressed.clear();
+	keysReleased.clear();
+	keysHeld.clear();
+
 	// Delete any IDLE keys
 	for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
 		if (key[i].kstate==IDLE) {
@@ -122,7 +678,8 @@ bool Keypad::updateList() {
 		    emptyPos = i;
 	}
 
-    uint32_t tmpTime = millis();
+	if (single_key)
+		return updateSingleKey(emptyPos);
 
 	// Add new keys to empty slots in the key list.
 	for (byte r=0; r<sizeKpd.rows; r++) {
@@ -150,10 +707,11 @@ bool Keypad::updateList() {
                         break;
                     }
                 }
+			} else if (eventLog != NULL) {
+                eventLog->dropped(keyCode, button, time_ms());
 			}
 		}
 	}
-    if (millis() - tmpTime > 0) Serial.printf("Keypad Time: %d\n", millis() - tmpTime);
 
 	// Report if the user changed the state of any key.
 	for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
@@ -163,22 +721,187 @@ bool Keypad::updateList() {
 	return false;
 }
 
+// Private : getKey() only wants the first new press. Advance the keys already on the
+// list straight from their bitMap bits, then stop at the first closed key not on it.
+bool Keypad::updateSingleKey(byte emptyPos) {
+	bool keyActivity = false;
+
+	for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
+		if (key[i].kchar == KEYPAD_NO_KEY)
+			continue;
+
+		nextKeyState(i, isClosed(key[i].kcode));
+		keyActivity |= key[i].stateChanged;
+	}
+
+	if (emptyPos == 0xFF)
+		return keyActivity;
+
+	for (byte r=0; r<sizeKpd.rows; r++) {
+		uint cols = bitMap[r];
+
+		while (cols) {
+			byte c = __builtin_ctz(cols);
+			cols &= cols - 1;
+
+			byte keyCode = r * sizeKpd.columns + c;
+			if (findInList(keyCode) >= 0)
+				continue;
+
+			key[emptyPos].kchar = keymap[keyCode];
+			key[emptyPos].kcode = keyCode;
+			key[emptyPos].kstate = IDLE;
+			nextKeyState(emptyPos, KEYPAD_CLOSED);
+			return true;
+		}
+	}
+
+	return keyActivity;
+}
+
+// Private : State of a key in the last scan.
+bool Keypad::isClosed(byte keyCode) {
+	return bitRead(bitMap[keyCode / sizeKpd.columns], keyCode % sizeKpd.columns);
+}
+
+// Walk the transitions of the last frame from the per-frame bitmaps: every PRESSED,
+// then HOLD, then RELEASED, lowest key code first. Call right after a getKeys()
+// that returned true, the bitmaps only hold the latest frame.
+void Keypad::forEachTransition(KeypadTransitionCallback callback, void *context) {
+	const KeyBitmap *maps[] = { &keysPressed, &keysHeld, &keysReleased };
+	const KeyState states[] = { PRESSED, HOLD, RELEASED };
+
+	for (byte m=0; m < 3; m++) {
+		KeyBitmapIterator it(*maps[m]);
+		int keyCode;
+
+		while ((keyCode = it.next()) >= 0)
+			callback(context, keyCode, states[m]);
+	}
+}
+
+// Private : Put a key in the first empty slot as IDLE. Returns -1 if the list is full.
+int8_t Keypad::addKey(byte keyCode) {
+	int8_t idx = findInList((char)KEYPAD_NO_KEY);
+
+	if (idx >= 0) {
+		key[idx].kchar = keymap[keyCode];
+		key[idx].kcode = keyCode;
+		key[idx].kstate = IDLE;
+		key[idx].stateChanged = false;
+	}
+
+	return idx;
+}
+
+// Save the keys that are down into retention memory before going to deep sleep.
+void Keypad::retain(KeypadRetained &state) {
+	state.magic = KEYPAD_RETAINED_MAGIC;
+	state.down = keysDown;
+}
+
+// Call right after begin() when waking from deep sleep. Samples the matrix at once,
+// without waiting for debounceTime, and fires the events the wake produced:
+// - keys down now that weren't before sleeping go PRESSED,
+// - retained keys that were let go while asleep go RELEASED (keys still down are
+//   restored silently, their PRESSED was reported before sleeping),
+// - if nothing is down any more, wakeKeyCode (when the wake source identifies the
+//   key) is reported as a full PRESSED + RELEASED tap, so a short tap isn't lost.
+// Returns the first key reported as PRESSED or KEYPAD_NO_KEY. getWakeLatency()
+// then gives the micros() at that moment, i.e. the time since reset.
+char Keypad::wake(KeypadRetained *state, int wakeKeyCode) {
+	bool restored = state != NULL && state->magic == KEYPAD_RETAINED_MAGIC;
+	char wakeChar = KEYPAD_NO_KEY;
+	int8_t idx;
+
+	keysPressed.clear();
+	keysReleased.clear();
+	keysHeld.clear();
+
+	scanKeys();
+
+	// The wake sample counts as settled.
+	for (byte r=0; r<sizeKpd.rows; r++)
+		stableMap[r] = rawMap[r];
+	rowsChanged = 0;
+
+	if (restored) {
+		KeyBitmapIterator it(state->down);
+		int keyCode;
+
+		while ((keyCode = it.next()) >= 0) {
+			// Retention memory can hold codes from a larger keypad, or garbage.
+			if (keyCode >= sizeKpd.rows * sizeKpd.columns)
+				continue;
+			if ((idx = addKey(keyCode)) < 0)
+				break;
+
+			key[idx].kstate = PRESSED;
+			keysDown.set(keyCode);
+			if (!isClosed(keyCode))
+				transitionTo(idx, RELEASED);
+			else {
+				holdTimer = time_ms();		// The time asleep is unknown, HOLD counts from the wake.
+				holdIdx = idx;
+			}
+		}
+		state->magic = 0;		// Only restore once.
+	}
+
+	for (byte keyCode=0; keyCode < sizeKpd.rows * sizeKpd.columns; keyCode++) {
+		if (!isClosed(keyCode) || findInList(keyCode) >= 0)
+			continue;
+		if ((idx = addKey(keyCode)) < 0)
+			break;
+
+		transitionTo(idx, PRESSED);
+		holdTimer = time_ms();
+		holdIdx = idx;
+		if (wakeChar == KEYPAD_NO_KEY)
+			wakeChar = key[idx].kchar;
+	}
+
+	if (wakeChar == KEYPAD_NO_KEY && wakeKeyCode >= 0 && wakeKeyCode < sizeKpd.rows * sizeKpd.columns
+			&& findInList((byte)wakeKeyCode) < 0 && (idx = addKey(wakeKeyCode)) >= 0) {
+		transitionTo(idx, PRESSED);
+		transitionTo(idx, RELEASED);
+		wakeChar = key[idx].kchar;
+	}
+
+	if (wakeChar != KEYPAD_NO_KEY)
+		wakeLatency = time_us();
+
+	startTime = time_ms();
+	return wakeChar;
+}
+
+// Microseconds from reset to the first event reported by wake(), 0 if there was none.
+unsigned long Keypad::getWakeLatency() {
+	return wakeLatency;
+}
+
 // Private
 // This function is a state machine but is also used for debouncing the keys.
 void Keypad::nextKeyState(byte idx, boolean button) {
+	bool justChanged = key[idx].stateChanged;
 	key[idx].stateChanged = false;
 
 	switch (key[idx].kstate) {
 		case IDLE:
 			if (button == KEYPAD_CLOSED) {
 				transitionTo(idx, PRESSED);
-				holdTimer = millis(); }		// Get ready for next HOLD state.
+				holdTimer = time_ms();		// Get ready for next HOLD state.
+				holdIdx = idx; }
 			break;
 		case PRESSED:
-			if ((millis()-holdTimer)>holdTime)	// Waiting for a key HOLD...
+			// In single key mode only the latest press owns holdTimer.
+			if ((!single_key || idx == holdIdx) && (time_ms()-holdTimer)>holdTime)	// Waiting for a key HOLD...
 				transitionTo(idx, HOLD);
-			else if (button == KEYPAD_OPEN)				// or for a key to be RELEASED.
+			else if (button == KEYPAD_OPEN) {			// or for a key to be RELEASED.
+				if (justChanged && eventLog != NULL)
+					eventLog->record(KEYPAD_LOG_BOUNCE, key[idx].kcode, time_ms());
 				transitionTo(idx, RELEASED);
+			}
 			break;
 		case HOLD:
 			if (button == KEYPAD_OPEN)
@@ -223,6 +946,11 @@ int8_t Keypad::findInList(byte keyCode) {
 	return -1;
 }
 
+// Look up the character a key code maps to in the current keymap.
+char Keypad::getKeyChar(byte keyCode) {
+	return keymap[keyCode];
+}
+
 // New in 2.0
 char Keypad::waitForKey() {
 	char waitKey = KEYPAD_NO_KEY;
@@ -269,19 +997,106 @@ void Keypad::addStatedEventListener(void (*listener)(char, KeyState)){
 	keypadStatedEventListener = listener;
 }
 
+// Dispatch transitions through a PROGMEM table laid out as table[keyCode][IDLE..RELEASED].
+// numCodes is the number of key codes (rows) in the table; codes past it have no actions.
+void Keypad::setActionTable(const KeypadAction *table, byte numCodes) {
+	actionTable = table;
+	actionCodes = numCodes;
+}
+
 void Keypad::transitionTo(byte idx, KeyState nextState) {
 	key[idx].kstate = nextState;
 	key[idx].stateChanged = true;
 
+	byte keyCode = key[idx].kcode;
+	if (eventLog != NULL)
+		eventLog->record(nextState, keyCode, time_ms());
+	if (keyTiming != NULL && (nextState == PRESSED || nextState == RELEASED))
+		keyTiming->edge(idx, keyCode, nextState);
+
+	if (single_key && nextState == PRESSED && singleKeyChar == KEYPAD_NO_KEY)
+		singleKeyChar = key[idx].kchar;
+
+	switch (nextState) {
+		case PRESSED:
+			keysPressed.set(keyCode);
+			keysDown.set(keyCode);
+			break;
+		case HOLD:
+			keysHeld.set(keyCode);
+			break;
+		case RELEASED:
+			keysReleased.set(keyCode);
+			keysDown.reset(keyCode);
+			break;
+		case IDLE:
+			break;
+	}
+
+	unsigned long t0;
+
 	// Calls keypadEventListener on any key that changes state.
     if (keypadEventListener!=NULL)  {
+        t0 = listenerBudget ? time_us() : 0;
         keypadEventListener(key[idx].kchar);
+        if (listenerBudget)
+            checkListener(KEYPAD_LISTENER_EVENT, key[idx].kchar, t0);
     }
     //call the event listener that contains the key state, if available
     if (keypadStatedEventListener!=NULL)
     {
+        t0 = listenerBudget ? time_us() : 0;
         keypadStatedEventListener(key[idx].kchar, nextState);
+        if (listenerBudget)
+            checkListener(KEYPAD_LISTENER_STATED, key[idx].kchar, t0);
     }
+    // One indexed load from flash, no compare chain per key.
+    if (actionTable != NULL && keyCode < actionCodes) {
+        KeypadAction entry;
+        memcpy_P(&entry, &actionTable[keyCode * 4 + nextState], sizeof(entry));
+        if (entry.action != NULL) {
+            t0 = listenerBudget ? time_us() : 0;
+            entry.action(entry.arg);
+            if (listenerBudget)
+                checkListener(KEYPAD_LISTENER_ACTION, key[idx].kchar, t0);
+        }
+    }
+}
+
+// Time every listener call against a budget, so slow handlers (printing at 9600 baud
+// for example) that delay every later key can be found. 0 turns timing off.
+void Keypad::setListenerBudget(unsigned long budgetMicros) {
+	listenerBudget = budgetMicros;
+}
+
+// Called with the listener, the key and how long it took whenever a listener goes over
+// budget. Its own run time isn't measured.
+void Keypad::addOverrunListener(void (*listener)(KeypadListenerId, char, unsigned long)) {
+	overrunListener = listener;
+}
+
+void Keypad::resetListenerStats() {
+	for (byte i=0; i < KEYPAD_LISTENERS; i++) {
+		listenerStats[i].maxMicros = 0;
+		listenerStats[i].overruns = 0;
+	}
+}
+
+// Private : Account for one listener call that started at startMicros.
+void Keypad::checkListener(KeypadListenerId id, char keyChar, unsigned long startMicros) {
+	unsigned long elapsed = time_us() - startMicros;
+	KeypadListenerStats &stats = listenerStats[id];
+
+	if (elapsed > stats.maxMicros)
+		stats.maxMicros = elapsed;
+
+	if (elapsed > listenerBudget) {
+		stats.overruns++;
+		if (eventLog != NULL)
+			eventLog->record(KEYPAD_LOG_OVERRUN, id, time_ms());
+		if (overrunListener != NULL)
+			overrunListener(id, keyChar, elapsed);
+	}
 }
 
 /*
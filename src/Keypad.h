@@ -76,63 +76,242 @@ typedef struct {
 } KeypadSize;
 
 #define KEYPAD_LIST_MAX 6		// Max number of keys on the active list.
-#define KEYPAD_MAPSIZE 5		// KEYPAD_MAPSIZE is the number of rows (times 16 columns)
+// KEYPAD_MAPSIZE is the number of rows (times 16 columns). Build with a larger value
+// (up to 15) to scan more rows, e.g. from a long KeypadShiftOut chain.
+#ifndef KEYPAD_MAPSIZE
+#define KEYPAD_MAPSIZE 5
+#endif
+#define KEYPAD_MAX_KEYS (KEYPAD_MAPSIZE * 8 * sizeof(uint))	// One key code per bit of bitMap.
+#define KEYPAD_SHIFT_MAX_REGISTERS 4	// Longest shift register chain the probes look for.
+#define KEYPAD_NO_PIN 0xFF
+// Build with KEYPAD_PIN_TRACE 1 to use setPinTrace(). Left at 0, pin_mode(),
+// pin_write() and pin_read() go straight to the core functions.
+#ifndef KEYPAD_PIN_TRACE
+#define KEYPAD_PIN_TRACE 0
+#endif
+
+#include "includes/KeyBitmap.h"
+#include "includes/KeySocd.h"
+#include "includes/KeySharedPins.h"
 
 #define makeKeymap(x) ((const char*)x)
 
+// One entry per (key code, KeyState), read from flash by transitionTo().
+// Entries with a NULL action are skipped.
+typedef struct {
+    void (*action)(int);
+    int arg;
+} KeypadAction;
+
+#define KEYPAD_NO_ACTION { NULL, 0 }
+#define makeActionTable(x) ((const KeypadAction*)x)
+
+// Called by Keypad::forEachTransition() with the context it was given.
+typedef void (*KeypadTransitionCallback)(void *context, byte keyCode, KeyState state);
+
+// Listener timing, see Keypad::setListenerBudget().
+typedef enum {
+	KEYPAD_LISTENER_EVENT,		// addEventListener()
+	KEYPAD_LISTENER_STATED,		// addStatedEventListener()
+	KEYPAD_LISTENER_ACTION,		// setActionTable() entries
+	KEYPAD_LISTENERS
+} KeypadListenerId;
+
+typedef struct {
+	unsigned long maxMicros;	// Longest single call.
+	uint overruns;				// Calls that took longer than the budget.
+} KeypadListenerStats;
+
+// Key state kept across deep sleep in retention memory (RTC RAM, .noinit, ...).
+// See Keypad::retain() and Keypad::wake().
+#define KEYPAD_RETAINED_MAGIC 0x4B50
+typedef struct {
+    uint16_t magic;
+    KeyBitmap down;
+} KeypadRetained;
+
+// Called by scanKeys() at every column read with the rows driven at that moment,
+// so another scanner can read along (KeypadGroup) or stamp rows (KeypadKeybed).
+// read = true: the rows in rowMask are driven. With a single row, read and store it.
+//   With several (an idle probe), return true if anything is active, and the scan
+//   descends into them even if this matrix sees nothing.
+// read = false: the probe found the rows in rowMask open, store them as empty.
+typedef bool (*KeypadScanHook)(void *context, uint rowMask, bool read);
+
+// How scanKeys() walks the matrix. See calibrateScan().
+typedef enum {
+	KEYPAD_SCAN_FULL,			// Strobe every row, every frame.
+	KEYPAD_SCAN_IDLE_PROBE,		// Strobe all rows at once and only do a full scan if a column is active.
+	KEYPAD_SCAN_BISECT,			// Like the probe, but split the active row groups in half down to single rows.
+	KEYPAD_SCAN_STRATEGIES
+} KeypadScanStrategy;
+
+
+class KeypadVcd;
+class KeypadLog;
+class KeypadTiming;
+template<class... Stages> class KeypadPipeline;
 
 //class Keypad : public Key, public HAL_obj {
 class Keypad : public Key {
+	friend class KeypadGroup;
+	friend class KeypadKeybed;
+	friend struct KeypadMatrixSource;
+	friend struct KeypadListEngine;
+	template<class Source, class Engine, class... Stages> friend class KeypadCustomPipeline;
 public:
 
 	Keypad(const byte *row, const byte *col, const byte numRows, const byte numCols);
 
-    void pin_mode(byte pinNum, byte mode) { pinMode(pinNum, mode); }
-    void pin_write(byte pinNum, boolean level) { digitalWrite(pinNum, level); }
-    int pin_read(byte pinNum) { return digitalRead(pinNum); }
+    // All pin and clock access goes through these so a subclass (I2C expander,
+    // host emulator, ...) can replace the hardware per instance.
+    virtual void pin_mode(byte pinNum, byte mode);
+    virtual void pin_write(byte pinNum, boolean level);
+    virtual int pin_read(byte pinNum);
+    virtual unsigned long time_ms() { return millis(); }
+    virtual unsigned long time_us() { return micros(); }
+    virtual void delay_us(uint micros) { delayMicroseconds(micros); }
 
     uint bitMap[KEYPAD_MAPSIZE];	// 10 row x 16 column array of bits. Except Due which has 32 columns.
 	Key key[KEYPAD_LIST_MAX];
 	unsigned long holdTimer;
 
+	// Per-frame key code bitmaps, rebuilt by every scan that updates the list.
+	KeyBitmap keysPressed;		// Went PRESSED this frame.
+	KeyBitmap keysReleased;		// Went RELEASED this frame.
+	KeyBitmap keysHeld;			// Went HOLD this frame.
+	KeyBitmap keysDown;			// Currently PRESSED or HOLD.
+	void forEachTransition(KeypadTransitionCallback callback, void *context);
+
+	KeypadListenerStats listenerStats[KEYPAD_LISTENERS];	// Only updated while a budget is set.
+
 	char getKey();
 	bool getKeys();
 	KeyState getState();
 	void begin(const char *userKeymap);
 	bool isPressed(char keyChar);
 	void setDebounceTime(uint);
+	void setScanRate(unsigned long idleMicros, unsigned long activeMicros, uint quietMillis = 100);
+	unsigned long getScanInterval();
 	void setHoldTime(uint);
+	void setLowPower(bool enable, uint settleMicros = 5);
+	bool setSharedPins(bool enable);
+	void setInterleaveHook(void (*hook)());
+	void setSocdRules(KeypadSocdRule *rules, byte count);
 	void addEventListener(void (*listener)(char));
 	void addStatedEventListener(void (*listener)(char, KeyState));
+	void setActionTable(const KeypadAction *table, byte numCodes);
+	void setListenerBudget(unsigned long budgetMicros);
+	void addOverrunListener(void (*listener)(KeypadListenerId, char, unsigned long));
+	void resetListenerStats();
+	bool setPinTrace(KeypadVcd *vcd);
+	void setLog(KeypadLog *log);
+	void setTiming(KeypadTiming *timing);
 	int8_t findInList(char keyChar);
 	int8_t findInList(byte keyCode);
+	char getKeyChar(byte keyCode);
+	void retain(KeypadRetained &state);
+	char wake(KeypadRetained *state = NULL, int wakeKeyCode = KEYPAD_UNASSIGNED);
+	unsigned long getWakeLatency();
 	char waitForKey();
 	bool keyStateChanged();
 	byte numKeys();
+	void setScanStrategy(KeypadScanStrategy strategy);
+	KeypadScanStrategy getScanStrategy();
+	void setCalibration(byte frames, byte maxMismatches = 0);
+	KeypadScanStrategy calibrateScan(byte frames, byte maxMismatches = 0);
+	unsigned long getScanCost(KeypadScanStrategy strategy);
 
 private:
 	unsigned long startTime;
 	const char *keymap;
     const byte *rowPins;
-	const KeypadSize sizeKpd;
 	uint debounceTime;
 	uint holdTime;
 	bool single_key;
+	bool lowPower;
+	uint settleTime;
+	bool sharedPins;
+	KeySharedPins sharedPorts;
+	void (*interleaveHook)();
+	char singleKeyChar;
+	byte holdIdx;
+	KeypadScanStrategy scanStrategy;
+	byte calibrationFrames;
+	byte calibrationMismatches;
+	unsigned long scanCost[KEYPAD_SCAN_STRATEGIES];
+	unsigned long wakeLatency;
+	unsigned long idleInterval;
+	unsigned long activeInterval;
+	uint quietTime;
+	unsigned long lastScanMicros;
+	unsigned long lastBusy;
+	bool scanFast;
+	uint rowsChanged;
+	uint rawMap[KEYPAD_MAPSIZE];		// Last scan, before debouncing and filters.
+	uint stableMap[KEYPAD_MAPSIZE];		// Rows that stayed put for debounceTime.
+	unsigned long rowChangedAt[KEYPAD_MAPSIZE];
+	KeypadSocdRule *socdRules;
+	byte socdCount;
+	KeypadScanHook scanHook;
+	void *scanContext;
 
-	void scanKeys();
+	bool scanFrame();
+	bool scanDue();
+	bool settleRows(bool debounce);
+	bool commitFrame();
+	bool listBusy();
+	void updateRate(bool busy);
+	bool debounceRows(unsigned long nowMicros);
+	void scanKeys(KeypadScanHook hook = NULL, void *context = NULL);
+	void beginScan();
+	void endScan();
+	void filterFrame();
+	void scanMatrix();
+	void scanRowRange(byte first, byte count);
+	static uint rowBits(byte count);
+	bool scanProbe(uint rowMask);
+	void scanRow(byte r);
+	void storeRow(byte r, uint cols);
+	void claimPins();
+	void releasePins();
+	void traceSharedPins(bool scanning);
+	void interleave();
+	virtual uint readColumns();
 	bool updateList();
+	bool updateSingleKey(byte emptyPos);
+	bool isClosed(byte keyCode);
+	int8_t addKey(byte keyCode);
 	void nextKeyState(byte n, boolean button);
 	void transitionTo(byte n, KeyState nextState);
     virtual void initColumnPins();
 	virtual void initRowPins();
+	void setColumnPullups(bool enable);
     virtual void writeRowPre(byte n);
     virtual void writeRowPost(byte n);
     virtual bool readRow(byte n);
+    virtual void driveRows(uint rowMask);
 	void (*keypadEventListener)(char);
 	void (*keypadStatedEventListener)(char, KeyState);
+	const KeypadAction *actionTable;
+	byte actionCodes;
+	unsigned long listenerBudget;
+	void (*overrunListener)(KeypadListenerId, char, unsigned long);
+	KeypadVcd *pinTrace;
+	KeypadLog *eventLog;
+	KeypadTiming *keyTiming;
+
+	void checkListener(KeypadListenerId id, char keyChar, unsigned long startMicros);
 
 protected:
+    // For subclasses that replace pin_mode()/pin_write()/pin_read(): pass every
+    // access on to the pin trace, if there is one.
+    void traceMode(byte pinNum, byte mode);
+    void traceWrite(byte pinNum, byte level);
+    void traceRead(byte pinNum, byte level);
+
     const byte *columnPins;
+	const KeypadSize sizeKpd;
 };
 
 #endif
@@ -0,0 +1,90 @@
+#include "KeypadEventQueue.h"
+
+KeypadEventQueue::KeypadEventQueue() {
+    clear();
+}
+
+void KeypadEventQueue::clear() {
+    head = 0;
+    count = 0;
+    coalesced = 0;
+    dropped = 0;
+}
+
+byte KeypadEventQueue::available() {
+    return count;
+}
+
+// Queue a transition. Returns false only if it had to be dropped, which can't
+// happen while KEYPAD_QUEUE_SIZE is at least the number of key codes pushed.
+bool KeypadEventQueue::push(byte keyCode, KeyState state) {
+    if (count >= KEYPAD_QUEUE_SIZE - KEYPAD_QUEUE_SLACK) {
+        // Newest pending entry of this key, so its transitions stay in order.
+        for (byte i=count; i-- > 0; ) {
+            if (at(i).keyCode == keyCode) {
+                merge(at(i), state);
+                return true;
+            }
+        }
+
+        if (count == KEYPAD_QUEUE_SIZE)
+            compact();
+        if (count == KEYPAD_QUEUE_SIZE) {
+            dropped++;
+            return false;
+        }
+    }
+
+    KeypadQueuedEvent &event = at(count++);
+    event.keyCode = keyCode;
+    event.state = state;
+    event.flags = 0;
+    return true;
+}
+
+// Queue the transitions of the last frame. Call right after a getKeys() that
+// returned true, the per-frame bitmaps only hold the latest frame.
+void KeypadEventQueue::capture(Keypad &kpd) {
+    kpd.forEachTransition(capture, this);
+}
+
+void KeypadEventQueue::capture(void *context, byte keyCode, KeyState state) {
+    ((KeypadEventQueue *)context)->push(keyCode, state);
+}
+
+bool KeypadEventQueue::pop(KeypadQueuedEvent &event) {
+    if (count == 0)
+        return false;
+
+    event = ring[head];
+    head = (head + 1) % KEYPAD_QUEUE_SIZE;
+    count--;
+    return true;
+}
+
+void KeypadEventQueue::merge(KeypadQueuedEvent &into, byte state) {
+    into.state = state;
+    into.flags |= KEYPAD_EVENT_COALESCED;
+    coalesced++;
+}
+
+// Merge every key's pending transitions into its oldest entry, in place.
+void KeypadEventQueue::compact() {
+    byte kept = 0;
+
+    for (byte i=0; i < count; i++) {
+        KeypadQueuedEvent event = at(i);
+        byte k = 0;
+
+        while (k < kept && at(k).keyCode != event.keyCode)
+            k++;
+
+        if (k < kept) {
+            merge(at(k), event.state);
+        } else {
+            at(kept++) = event;
+        }
+    }
+
+    count = kept;
+}
@@ -0,0 +1,55 @@
+#ifndef KEYPAD_EVENT_QUEUE_H
+#define KEYPAD_EVENT_QUEUE_H
+
+#include "Keypad.h"
+
+#ifndef KEYPAD_QUEUE_SIZE
+#define KEYPAD_QUEUE_SIZE 32		// Keep it >= the number of keys, see below.
+#endif
+#define KEYPAD_QUEUE_SLACK 4		// Start coalescing when this few slots are left.
+
+#define KEYPAD_EVENT_COALESCED 0x01	// Stands for several transitions of the key.
+
+typedef struct {
+    byte keyCode;
+    byte state;		// KeyState
+    byte flags;
+} KeypadQueuedEvent;
+
+// Transition queue for a consumer that may fall behind. Events queue up in order
+// until the queue is nearly full. From then on a new transition for a key that
+// already has one pending replaces that entry's state with the newest one and flags
+// it KEYPAD_EVENT_COALESCED, instead of taking a slot. If the queue fills anyway,
+// all pending transitions are merged per key to make room.
+//
+// A merged entry always carries the key's latest state, so a RELEASED is never
+// lost behind an older PRESSED. Once fully merged there is at most one entry per
+// key, so with KEYPAD_QUEUE_SIZE >= the number of keys nothing is ever dropped and
+// a stalled consumer still ends up with the right set of pressed keys.
+class KeypadEventQueue {
+public:
+    KeypadEventQueue();
+
+    bool push(byte keyCode, KeyState state);
+    void capture(Keypad &kpd);
+    bool pop(KeypadQueuedEvent &event);
+    byte available();
+    void clear();
+
+    unsigned long getCoalesced() { return coalesced; }
+    unsigned long getDropped() { return dropped; }
+
+private:
+    KeypadQueuedEvent ring[KEYPAD_QUEUE_SIZE];
+    byte head;		// Oldest event.
+    byte count;
+    unsigned long coalesced;
+    unsigned long dropped;
+
+    KeypadQueuedEvent &at(byte i) { return ring[(head + i) % KEYPAD_QUEUE_SIZE]; }
+    void merge(KeypadQueuedEvent &into, byte state);
+    void compact();
+    static void capture(void *context, byte keyCode, KeyState state);
+};
+
+#endif
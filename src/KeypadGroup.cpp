@@ -0,0 +1,77 @@
+#include "KeypadGroup.h"
+
+KeypadGroup::KeypadGroup(Keypad &rowDriver) {
+    matrices[0] = &rowDriver;
+    count = 1;
+}
+
+// Add a matrix that shares the driver's rows. Call begin() on it as usual, it only
+// reconfigures the shared row pins to the same state, and give it the driver's
+// setLowPower() setting for the same reason. Returns false if the group is full.
+bool KeypadGroup::add(Keypad &matrix) {
+    if (count >= KEYPAD_GROUP_MAX)
+        return false;
+
+    matrices[count++] = &matrix;
+    return true;
+}
+
+// Same as Keypad::getKeys() for every matrix in the group, when the driver is due.
+bool KeypadGroup::getKeys() {
+    Keypad &driver = *matrices[0];
+    bool debounce = driver.activeInterval != 0;
+    bool keyActivity = false;
+    bool busy = false;
+
+    if (!driver.scanDue())
+        return false;
+
+    for (byte m=1; m < count; m++)
+        matrices[m]->beginScan();
+    driver.scanKeys(readAlong, this);
+    for (byte m=1; m < count; m++)
+        matrices[m]->endScan();
+
+    for (byte m=0; m < count; m++) {
+        Keypad &matrix = *matrices[m];
+
+        busy |= matrix.settleRows(debounce);
+        matrix.filterFrame();
+        matrix.single_key = false;
+        keyActivity |= matrix.commitFrame();
+        if (m > 0)
+            busy |= matrix.listBusy();
+    }
+
+    driver.updateRate(busy);
+    return keyActivity;
+}
+
+// Scan hook: read the other matrices' columns while the driver has rows driven.
+bool KeypadGroup::readAlong(void *context, uint rowMask, bool read) {
+    KeypadGroup &group = *(KeypadGroup *)context;
+    bool seen = false;
+
+    for (byte m=1; m < group.count; m++) {
+        Keypad &matrix = *group.matrices[m];
+        uint rows = rowMask & Keypad::rowBits(matrix.sizeKpd.rows);
+
+        if (!rows)
+            continue;
+
+        if (!read) {
+            for (byte r=0; r < matrix.sizeKpd.rows; r++) {
+                if (bitRead(rows, r))
+                    matrix.storeRow(r, 0);
+            }
+            continue;
+        }
+
+        uint cols = matrix.readColumns();
+        if (!(rows & (rows - 1)))
+            matrix.storeRow(__builtin_ctz(rows), cols);
+        seen |= cols != 0;
+    }
+
+    return seen;
+}
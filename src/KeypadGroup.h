@@ -0,0 +1,33 @@
+#ifndef KEYPAD_GROUP_H
+#define KEYPAD_GROUP_H
+
+#include "Keypad.h"
+
+#define KEYPAD_GROUP_MAX 4		// Matrices that can share one set of row drivers.
+
+// Scans several matrices whose rows are wired to the same pins (or the same 595
+// chain) but whose columns are separate. Each row is strobed once, all column
+// sets are read during that strobe, and the row words go to each matrix's own
+// bitMap, keymap and key list. Use this instead of calling getKeys() on every
+// matrix, which would strobe the shared rows once per matrix.
+//
+// The scan is the row driver's own: its scan strategy, interleave hook and scan
+// rate (setScanRate()) apply to the whole group, and an idle probe only skips rows
+// that are open on every matrix. Each matrix switches its own column pull-ups for
+// low power and keeps its own shared pins, filters and timing. With an adaptive
+// rate every matrix debounces its rows for its own debounceTime.
+class KeypadGroup {
+public:
+    KeypadGroup(Keypad &rowDriver);
+
+    bool add(Keypad &matrix);
+    bool getKeys();
+
+private:
+    Keypad *matrices[KEYPAD_GROUP_MAX];		// [0] is the row driver.
+    byte count;
+
+    static bool readAlong(void *context, uint rowMask, bool read);
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "KeypadKeybed.h"
+
+// Pair states.
+#define KEYBED_IDLE 0
+#define KEYBED_ARMED 1		// First contact closed, waiting for the second.
+#define KEYBED_ON 2
+#define KEYBED_RELEASING 3	// Second contact open, waiting for the first.
+
+KeypadKeybed::KeypadKeybed(Keypad &kpd, const KeypadContactPair *pairs, byte count): kpd(kpd) {
+    this->pairs = pairs;
+    this->count = count < KEYPAD_KEYBED_KEYS ? count : KEYPAD_KEYBED_KEYS;
+    for (byte i=0; i < KEYPAD_KEYBED_KEYS; i++) {
+        state[i] = KEYBED_IDLE;
+        since[i] = 0;
+        contacts[i] = 0;
+        changedAt[i][0] = changedAt[i][1] = 0;
+    }
+    for (byte r=0; r < KEYPAD_MAPSIZE; r++)
+        stamps[r] = 0;
+    contactDebounce = KEYPAD_KEYBED_DEBOUNCE;
+
+    for (byte r=0; r < KEYPAD_MAPSIZE; r++)
+        pairMask[r] = 0;
+    for (byte i=0; i < this->count; i++) {
+        pairMask[pairs[i].first / kpd.sizeKpd.columns] |= 1U << (pairs[i].first % kpd.sizeKpd.columns);
+        pairMask[pairs[i].second / kpd.sizeKpd.columns] |= 1U << (pairs[i].second % kpd.sizeKpd.columns);
+    }
+
+    curve = NULL;
+    curveSize = 0;
+    maxMicros = 50000;
+    noteListener = 0;
+}
+
+// curve is a PROGMEM table of velocities (1-127), fastest first, spread evenly over
+// 0..maxMicros. Slower keys get the last entry. Without a curve the velocity falls
+// linearly from 127 to 1 over maxMicros.
+void KeypadKeybed::setVelocityCurve(const byte *curve, byte size, unsigned long maxMicros) {
+    this->curve = size ? curve : NULL;
+    curveSize = size;
+    this->maxMicros = maxMicros ? maxMicros : 1;
+}
+
+void KeypadKeybed::addNoteListener(void (*listener)(byte note, byte velocity, bool on)) {
+    noteListener = listener;
+}
+
+// Time a contact must read the same before a change is accepted. 0 takes every scan
+// as it comes.
+void KeypadKeybed::setContactDebounce(unsigned long micros) {
+    contactDebounce = micros;
+}
+
+// Scan the matrix once and report note on/off for every pair that completed.
+// Returns true if a note went on or off, or a key on the key list changed state.
+bool KeypadKeybed::scan() {
+    bool activity = false;
+
+    kpd.scanKeys(stamp, this);
+
+    for (byte i=0; i < count; i++)
+        activity |= updatePair(i);
+
+    if (kpd.scanDue()) {
+        bool settling = kpd.settleRows(kpd.activeInterval != 0);
+
+        // The contacts are notes, keep them off the key list.
+        for (byte r=0; r < kpd.sizeKpd.rows; r++)
+            kpd.bitMap[r] &= ~pairMask[r];
+
+        kpd.single_key = false;
+        kpd.filterFrame();
+        activity |= kpd.commitFrame();
+        kpd.updateRate(settling);
+    }
+
+    return activity;
+}
+
+// Scan hook: stamp each row as it is read, or cleared by an idle probe.
+bool KeypadKeybed::stamp(void *context, uint rowMask, bool read) {
+    KeypadKeybed &keybed = *(KeypadKeybed *)context;
+    unsigned long now = keybed.kpd.time_us();
+
+    // A probe of several rows only reads, the rows are stamped when strobed one by one.
+    if (read && (rowMask & (rowMask - 1)))
+        return false;
+
+    for (byte r=0; r < keybed.kpd.sizeKpd.rows; r++) {
+        if (bitRead(rowMask, r))
+            keybed.stamps[r] = now;
+    }
+    return false;
+}
+
+// Debounce one contact of pair i. contacts[i] holds the stable state of the first
+// and second contact in bits 0 and 1, and whether each has a change pending in
+// bits 2 and 3. Returns the stable state; changedAt[i][contact] dates its last change.
+bool KeypadKeybed::settle(byte i, byte contact, byte keyCode) {
+    byte stableBit = 1 << contact;
+    byte pendingBit = 4 << contact;
+    bool stable = contacts[i] & stableBit;
+    unsigned long stamp = stamps[keyCode / kpd.sizeKpd.columns];
+
+    if (kpd.isClosed(keyCode) == stable) {
+        contacts[i] &= ~pendingBit;
+        return stable;
+    }
+
+    if (!(contacts[i] & pendingBit)) {
+        contacts[i] |= pendingBit;
+        changedAt[i][contact] = stamp;
+    }
+
+    if (stamp - changedAt[i][contact] < contactDebounce)
+        return stable;
+
+    contacts[i] = (contacts[i] ^ stableBit) & ~pendingBit;
+    return !stable;
+}
+
+bool KeypadKeybed::updatePair(byte i) {
+    const KeypadContactPair &pair = pairs[i];
+    bool first = settle(i, 0, pair.first);
+    bool second = settle(i, 1, pair.second);
+    unsigned long firstStamp = changedAt[i][0];
+    unsigned long secondStamp = changedAt[i][1];
+
+    switch (state[i]) {
+        case KEYBED_IDLE:
+            if (second) {
+                // Both contacts closed within one scan: as fast as we can tell.
+                state[i] = KEYBED_ON;
+                if (noteListener != NULL)
+                    noteListener(pair.note, velocity(0), true);
+                return true;
+            }
+            if (first) {
+                state[i] = KEYBED_ARMED;
+                since[i] = firstStamp;
+            }
+            return false;
+        case KEYBED_ARMED:
+            if (second) {
+                state[i] = KEYBED_ON;
+                if (noteListener != NULL)
+                    noteListener(pair.note, velocity(secondStamp - since[i]), true);
+                return true;
+            }
+            if (!first)
+                state[i] = KEYBED_IDLE;		// Pressed half way and let go.
+            return false;
+        case KEYBED_ON:
+            if (second)
+                return false;
+            if (first) {
+                state[i] = KEYBED_RELEASING;
+                since[i] = secondStamp;
+                return false;
+            }
+            state[i] = KEYBED_IDLE;
+            if (noteListener != NULL)
+                noteListener(pair.note, velocity(0), false);
+            return true;
+        case KEYBED_RELEASING:
+            if (second) {
+                state[i] = KEYBED_ON;		// Pressed again before the key came all the way up.
+                return false;
+            }
+            if (first)
+                return false;
+            state[i] = KEYBED_IDLE;
+            if (noteListener != NULL)
+                noteListener(pair.note, velocity(firstStamp - since[i]), false);
+            return true;
+    }
+
+    return false;
+}
+
+byte KeypadKeybed::velocity(unsigned long interval) {
+    if (interval > maxMicros)
+        interval = maxMicros;
+
+    if (curve == NULL)
+        return 127 - (byte)(126 * interval / maxMicros);
+
+    return pgm_read_byte(curve + interval * (curveSize - 1) / maxMicros);
+}
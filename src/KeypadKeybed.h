@@ -0,0 +1,67 @@
+#ifndef KEYPAD_KEYBED_H
+#define KEYPAD_KEYBED_H
+
+#include "Keypad.h"
+
+#ifndef KEYPAD_KEYBED_KEYS
+#define KEYPAD_KEYBED_KEYS 32		// Contact pairs one keybed can track.
+#endif
+#ifndef KEYPAD_KEYBED_DEBOUNCE
+#define KEYPAD_KEYBED_DEBOUNCE 1000	// Microseconds a contact must hold a new state.
+#endif
+
+// The two matrix positions of a velocity sensing key. The first contact closes
+// early in the key travel, the second at the bottom.
+typedef struct {
+    byte first;		// Key codes.
+    byte second;
+    byte note;
+} KeypadContactPair;
+
+// Velocity sensing keybed on top of a Keypad. Every scan() scans the matrix with
+// kpd's scan strategy, pins and timing, and stamps each row with time_us() as it
+// is read, without waiting for debounceTime, so call it as often as possible: the
+// velocity resolution is the scan period. The time from the first contact closing
+// to the second one closing is mapped through a velocity curve into a note on; on
+// the way up the time from the second contact opening to the first one opening
+// gives the note off (release) velocity.
+//
+// Each contact is debounced on its own: a change counts once the contact has read
+// the same for setContactDebounce() microseconds, and is dated from the scan that
+// first saw it, so the debounce delays the note but doesn't skew the velocity.
+//
+// Keys that aren't part of a pair (octave buttons, ...) still go through the usual
+// key list, events and listeners, whenever kpd is due for a scan (debounceTime, or
+// setScanRate()).
+class KeypadKeybed {
+public:
+    KeypadKeybed(Keypad &kpd, const KeypadContactPair *pairs, byte count);
+
+    void setVelocityCurve(const byte *curve, byte size, unsigned long maxMicros);
+    void addNoteListener(void (*listener)(byte note, byte velocity, bool on));
+    void setContactDebounce(unsigned long micros);
+    bool scan();
+
+private:
+    Keypad &kpd;
+    const KeypadContactPair *pairs;
+    byte count;
+    byte state[KEYPAD_KEYBED_KEYS];
+    unsigned long since[KEYPAD_KEYBED_KEYS];
+    byte contacts[KEYPAD_KEYBED_KEYS];			// Stable and pending bits, see settle().
+    unsigned long changedAt[KEYPAD_KEYBED_KEYS][2];	// When each contact's pending change was first seen.
+    unsigned long contactDebounce;
+    unsigned long stamps[KEYPAD_MAPSIZE];		// When each row was last read.
+    uint pairMask[KEYPAD_MAPSIZE];		// Contacts that belong to a pair, by row.
+    const byte *curve;
+    byte curveSize;
+    unsigned long maxMicros;
+    void (*noteListener)(byte, byte, bool);
+
+    static bool stamp(void *context, uint rowMask, bool read);
+    bool settle(byte i, byte contact, byte keyCode);
+    bool updatePair(byte i);
+    byte velocity(unsigned long interval);
+};
+
+#endif
@@ -0,0 +1,194 @@
+#if defined(__linux__)
+
+#include "KeypadLinuxGpio.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+KeypadLinuxGpio::KeypadLinuxGpio(const char *chipPath, const byte *rowLines, const byte *colLines, const byte numRows, const byte numCols): Keypad(NULL, NULL, numRows, numCols) {
+    this->chipPath = chipPath;
+    this->rowLines = rowLines;
+    this->colLines = colLines;
+
+    chipFd = -1;
+    rowFd = -1;
+    colFd = -1;
+    rowMask = (numRows < 64 ? (1ULL << numRows) : 0) - 1;
+    colMask = (numCols < 64 ? (1ULL << numCols) : 0) - 1;
+}
+
+KeypadLinuxGpio::~KeypadLinuxGpio() {
+    closeFd(rowFd);
+    closeFd(colFd);
+    closeFd(chipFd);
+}
+
+int KeypadLinuxGpio::chip() {
+    if (chipFd < 0)
+        chipFd = openChip(chipPath);
+    return chipFd;
+}
+
+// Rows are outputs, idle HIGH.
+void KeypadLinuxGpio::initRowPins() {
+    closeFd(rowFd);
+    rowFd = requestLines(chip(), rowLines, sizeKpd.rows, GPIO_V2_LINE_FLAG_OUTPUT, rowMask);
+}
+
+// Columns are pulled up inputs that report falling edges for waitForActivity().
+void KeypadLinuxGpio::initColumnPins() {
+    closeFd(colFd);
+    colFd = requestLines(chip(), colLines, sizeKpd.columns,
+            GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_UP | GPIO_V2_LINE_FLAG_EDGE_FALLING, 0);
+}
+
+// One ioctl per strobe: the selected row LOW, all others HIGH. The next strobe
+// (or driveRows()) sets every row again, so writeRowPost() has nothing to do.
+void KeypadLinuxGpio::writeRowPre(byte n) {
+    setValues(rowFd, rowMask & ~(1ULL << n), rowMask);
+}
+
+void KeypadLinuxGpio::writeRowPost(byte) {}
+
+void KeypadLinuxGpio::driveRows(uint rows) {
+    setValues(rowFd, rowMask & ~(uint64_t)rows, rowMask);
+}
+
+bool KeypadLinuxGpio::readRow(byte n) {
+    uint64_t bits;
+    return getValues(colFd, 1ULL << n, bits) && !(bits & (1ULL << n));
+}
+
+// All columns in one ioctl.
+uint KeypadLinuxGpio::readColumns() {
+    uint64_t bits;
+
+    if (!getValues(colFd, colMask, bits))
+        return 0;
+    return (uint)(~bits & colMask);
+}
+
+// Drive every row LOW and sleep until a column sees a falling edge, or timeoutMs
+// passes (-1 waits forever). Returns true if a key is down or went down. The rows
+// are left HIGH again for the next scan.
+bool KeypadLinuxGpio::waitForActivity(int timeoutMs) {
+    if (!isOpen())
+        return false;
+
+    // Every scan strobes the rows, so a held or bouncing key leaves falling edges
+    // queued that would end the wait at once.
+    drainEdges(colFd);
+
+    setValues(rowFd, 0, rowMask);
+
+    // A key that is already down won't produce an edge.
+    bool activity = readColumns() != 0;
+    if (!activity)
+        activity = waitEdge(colFd, timeoutMs) > 0;
+
+    setValues(rowFd, rowMask, rowMask);
+    return activity;
+}
+
+int KeypadLinuxGpio::openChip(const char *path) {
+    return open(path, O_RDWR | O_CLOEXEC);
+}
+
+int KeypadLinuxGpio::requestLines(int chipFd, const byte *lines, byte count, uint64_t flags, uint64_t outputs) {
+    struct gpio_v2_line_request req;
+
+    if (chipFd < 0 || count > GPIO_V2_LINES_MAX)
+        return -1;
+
+    memset(&req, 0, sizeof(req));
+    for (byte i=0; i < count; i++)
+        req.offsets[i] = lines[i];
+    req.num_lines = count;
+    strncpy(req.consumer, "keypad", sizeof(req.consumer) - 1);
+    req.config.flags = flags;
+
+    if (flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+        req.config.num_attrs = 1;
+        req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        req.config.attrs[0].attr.values = outputs;
+        req.config.attrs[0].mask = count < 64 ? (1ULL << count) - 1 : ~0ULL;
+    }
+
+    if (ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+        return -1;
+
+    // Edge events are drained without blocking, see drainEdges().
+    fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+    return req.fd;
+}
+
+bool KeypadLinuxGpio::setValues(int fd, uint64_t bits, uint64_t mask) {
+    struct gpio_v2_line_values values;
+
+    values.bits = bits;
+    values.mask = mask;
+    return fd >= 0 && ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) >= 0;
+}
+
+bool KeypadLinuxGpio::getValues(int fd, uint64_t mask, uint64_t &bits) {
+    struct gpio_v2_line_values values;
+
+    values.bits = 0;
+    values.mask = mask;
+    if (fd < 0 || ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+        return false;
+
+    bits = values.bits;
+    return true;
+}
+
+// Wait for edge events and drain them. Returns the number of events read,
+// 0 on timeout or -1 on error.
+int KeypadLinuxGpio::waitEdge(int fd, int timeoutMs) {
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready <= 0)
+        return ready;
+
+    return drainEdges(fd);
+}
+
+// Read queued edge events until the (non-blocking) line fd runs dry. Returns the
+// number of events read or -1 on error.
+int KeypadLinuxGpio::drainEdges(int fd) {
+    struct gpio_v2_line_event events[16];
+    int count = 0;
+
+    if (fd < 0)
+        return -1;
+
+    for (;;) {
+        ssize_t len = read(fd, events, sizeof(events));
+
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? count : -1;
+        }
+        if (len == 0)
+            return count;
+
+        count += len / sizeof(events[0]);
+    }
+}
+
+void KeypadLinuxGpio::closeFd(int fd) {
+    if (fd >= 0)
+        close(fd);
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef KEYPAD_LINUXGPIO_H
+#define KEYPAD_LINUXGPIO_H
+
+#if defined(__linux__)
+
+#include "Keypad.h"
+
+// Scans a matrix wired to a Linux GPIO chip through the character device
+// (/dev/gpiochipN, GPIO uAPI v2). Rows and columns are each requested as one
+// line group, so a row strobe is a single set-values ioctl and reading all the
+// columns a single get-values ioctl, instead of a syscall per pin.
+// Columns get pull-ups and falling edge events, which waitForActivity() uses to
+// sleep until a key goes down.
+//
+// The ioctl wrappers are virtual so the backend can be tested against a fake chip,
+// see extras/host/gpiotest.cpp.
+class KeypadLinuxGpio: public Keypad {
+public:
+    KeypadLinuxGpio(const char *chipPath, const byte *rowLines, const byte *colLines, const byte numRows, const byte numCols);
+    ~KeypadLinuxGpio();
+
+    bool isOpen() { return rowFd >= 0 && colFd >= 0; }
+    bool waitForActivity(int timeoutMs);
+
+protected:
+    virtual int openChip(const char *path);
+    virtual int requestLines(int chipFd, const byte *lines, byte count, uint64_t flags, uint64_t outputs);
+    virtual bool setValues(int fd, uint64_t bits, uint64_t mask);
+    virtual bool getValues(int fd, uint64_t mask, uint64_t &bits);
+    virtual int waitEdge(int fd, int timeoutMs);
+    virtual int drainEdges(int fd);
+    virtual void closeFd(int fd);
+
+private:
+    const char *chipPath;
+    const byte *rowLines;
+    const byte *colLines;
+    int chipFd;
+    int rowFd;
+    int colFd;
+    uint64_t rowMask;
+    uint64_t colMask;
+
+    void initRowPins();
+    void initColumnPins();
+    void writeRowPre(byte n);
+    void writeRowPost(byte);
+    void driveRows(uint rows);
+    bool readRow(byte n);
+    uint readColumns();
+    int chip();
+};
+
+#endif
+
+#endif
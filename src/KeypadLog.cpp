@@ -0,0 +1,66 @@
+#include "KeypadLog.h"
+
+#define KEYPAD_LOG_VERSION 1
+
+static const char *const kindNames[] = {
+    "IDLE", "PRESSED", "HOLD", "RELEASED", "BOUNCE", "DROPPED", "OVERRUN", "TIME"
+};
+
+KeypadLog::KeypadLog() {
+    lastMs = 0;
+    clear();
+}
+
+void KeypadLog::clear() {
+    head = 0;
+    count = 0;
+}
+
+byte KeypadLog::size() {
+    return count;
+}
+
+void KeypadLog::dumpBinary(Print &out) {
+    byte idx = (head + KEYPAD_LOG_RECORDS - count) % KEYPAD_LOG_RECORDS;
+
+    out.write('K');
+    out.write('L');
+    out.write(KEYPAD_LOG_VERSION);
+    out.write(count);
+
+    for (byte i=0; i < count; i++) {
+        out.write(ring[idx][0]);
+        out.write(ring[idx][1]);
+        out.write(ring[idx][2]);
+        if (++idx == KEYPAD_LOG_RECORDS)
+            idx = 0;
+    }
+}
+
+// One line per record: milliseconds since the oldest record, kind, key code.
+void KeypadLog::dumpText(Print &out) {
+    byte idx = (head + KEYPAD_LOG_RECORDS - count) % KEYPAD_LOG_RECORDS;
+    unsigned long t = 0;
+
+    for (byte i=0; i < count; i++) {
+        byte kind = ring[idx][0] >> 5;
+
+        if (i > 0) {
+            if (kind == KEYPAD_LOG_TIME)
+                t += (unsigned long)(ring[idx][0] & 0x1F) << 16 | (uint)ring[idx][1] << 8 | ring[idx][2];
+            else
+                t += (uint)(ring[idx][0] & 0x1F) << 8 | ring[idx][1];
+        }
+
+        if (kind != KEYPAD_LOG_TIME) {
+            out.print(t);
+            out.print(' ');
+            out.print(kindNames[kind]);
+            out.print(' ');
+            out.println((uint)ring[idx][2]);
+        }
+
+        if (++idx == KEYPAD_LOG_RECORDS)
+            idx = 0;
+    }
+}
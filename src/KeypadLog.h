@@ -0,0 +1,93 @@
+#ifndef KEYPAD_LOG_H
+#define KEYPAD_LOG_H
+
+#include "Keypad.h"
+
+#ifndef KEYPAD_LOG_RECORDS
+#define KEYPAD_LOG_RECORDS 32		// 3 bytes each.
+#endif
+
+#define KEYPAD_LOG_DELTA_MAX 0x1FFF		// 13 bit delta in a key record, ~8 s.
+#define KEYPAD_LOG_TIME_MAX 0x1FFFFF	// 21 bit delta in a time record, ~35 min.
+
+// Record kinds. The first four are the KeyState a key went to.
+typedef enum {
+    KEYPAD_LOG_IDLE = IDLE,
+    KEYPAD_LOG_PRESSED = PRESSED,
+    KEYPAD_LOG_HOLD = HOLD,
+    KEYPAD_LOG_RELEASED = RELEASED,
+    KEYPAD_LOG_BOUNCE,		// Released one frame after going PRESSED.
+    KEYPAD_LOG_DROPPED,		// Closed, but the key list was full.
+    KEYPAD_LOG_OVERRUN,		// A listener went over budget, code is the KeypadListenerId.
+    KEYPAD_LOG_TIME			// Only carries a long delta.
+} KeypadLogKind;
+
+// Black box for the keypad: a ring of the last KEYPAD_LOG_RECORDS transitions and
+// anomalies, cheap enough to leave attached in production (Keypad::setLog()) and
+// dump when someone reports a missed press.
+//
+// Each record is 3 bytes: kind (3 bits) and milliseconds since the previous record
+// (13 bits), then the key code. Longer gaps are written as a KEYPAD_LOG_TIME record
+// first. dumpBinary() writes "KL", a version byte, the record count and the records,
+// oldest first; the first delta is relative to a record that was already overwritten.
+class KeypadLog {
+public:
+    KeypadLog();
+
+    void record(byte kind, byte code, unsigned long nowMs);
+    void dropped(byte code, bool closed, unsigned long nowMs);
+    void clear();
+    byte size();
+
+    void dumpBinary(Print &out);
+    void dumpText(Print &out);
+
+private:
+    byte ring[KEYPAD_LOG_RECORDS][3];
+    byte head;		// Next record to write.
+    byte count;
+    unsigned long lastMs;
+    KeyBitmap droppedKeys;		// Logged as dropped and still closed.
+
+    void put(byte b0, byte b1, byte b2);
+};
+
+inline void KeypadLog::put(byte b0, byte b1, byte b2) {
+    ring[head][0] = b0;
+    ring[head][1] = b1;
+    ring[head][2] = b2;
+
+    if (++head == KEYPAD_LOG_RECORDS)
+        head = 0;
+    if (count < KEYPAD_LOG_RECORDS)
+        count++;
+}
+
+inline void KeypadLog::record(byte kind, byte code, unsigned long nowMs) {
+    unsigned long delta = nowMs - lastMs;
+    lastMs = nowMs;
+
+    if (delta > KEYPAD_LOG_DELTA_MAX) {
+        if (delta > KEYPAD_LOG_TIME_MAX)
+            delta = KEYPAD_LOG_TIME_MAX;
+        put(KEYPAD_LOG_TIME << 5 | delta >> 16, delta >> 8, delta);
+        delta = 0;
+    }
+
+    put(kind << 5 | delta >> 8, delta, code);
+
+    if (kind == KEYPAD_LOG_PRESSED)
+        droppedKeys.reset(code);
+}
+
+// Called every frame for keys that aren't on the list, logs each dropped press once.
+inline void KeypadLog::dropped(byte code, bool closed, unsigned long nowMs) {
+    if (!closed)
+        droppedKeys.reset(code);
+    else if (!droppedKeys.test(code)) {
+        droppedKeys.set(code);
+        record(KEYPAD_LOG_DROPPED, code, nowMs);
+    }
+}
+
+#endif
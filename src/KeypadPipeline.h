@@ -0,0 +1,172 @@
+#ifndef KEYPAD_PIPELINE_H
+#define KEYPAD_PIPELINE_H
+
+#include "Keypad.h"
+
+// A scan pipeline assembled from stage types at compile time:
+//
+//     source -> row filters -> frame filters -> engine -> sinks
+//
+// Only the listed stages are compiled in, with no runtime checks for the ones that
+// aren't, and every call between stages is static so the compiler can inline all
+// the row filters into one pass over the row words, run once the frame is scanned.
+//
+//     KeypadSocdRule socd[] = { KEYPAD_SOCD_RULE(4, 6, KEYPAD_SOCD_LAST_WINS) };
+//     void onKey(byte keyCode, KeyState state) { ... }
+//
+//     KeypadPipeline<KeypadSocdStage<socd, 1>, KeypadEventSink<onKey> > pipeline(kpd);
+//
+//     void loop() { pipeline.getKeys(); }
+//
+// KeypadPipeline uses kpd's own scan as the source and its key list as the engine,
+// so call pipeline.getKeys() instead of kpd.getKeys(). Runtime filters set on kpd
+// (setSocdRules()) are skipped. What stays dynamic is inside those two stages: the
+// scan strategy, setScanRate(), low power, shared pins, the interleave hook, timing
+// and pin trace are still chosen at run time by the source, and the listeners,
+// action table and log by the engine. KeypadCustomPipeline takes other source and
+// engine types with the same members as KeypadMatrixSource and KeypadListEngine.
+
+// Base for stages: every hook defaults to pass-through. A stage overrides the hooks
+// it needs, hiding these (they are not virtual).
+struct KeypadStage {
+    // Filter one row word (one bit per column). Runs on every row of a scanned frame.
+    uint row(byte, uint cols) { return cols; }
+    // Filter the whole frame after the row filters.
+    void frame(uint *, byte, byte) {}
+    // Receive a transition from the state machine.
+    void event(byte, KeyState) {}
+};
+
+// Chains stages in order. Each hook runs through every stage.
+template<class... Stages> struct KeypadStages {
+    uint row(byte, uint cols) { return cols; }
+    void frame(uint *, byte, byte) {}
+    void event(byte, KeyState) {}
+};
+
+template<class First, class... Rest> struct KeypadStages<First, Rest...> {
+    First first;
+    KeypadStages<Rest...> rest;
+
+    uint row(byte r, uint cols) { return rest.row(r, first.row(r, cols)); }
+
+    void frame(uint *rows, byte numRows, byte numCols) {
+        first.frame(rows, numRows, numCols);
+        rest.frame(rows, numRows, numCols);
+    }
+
+    void event(byte keyCode, KeyState state) {
+        first.event(keyCode, state);
+        rest.event(keyCode, state);
+    }
+};
+
+// Source: Keypad's scan, on its own schedule (debounceTime, or setScanRate() with
+// the per-row debounce).
+struct KeypadMatrixSource {
+    bool settling;
+
+    // Fill kpd.bitMap. Returns false if no frame is due.
+    bool scan(Keypad &kpd) {
+        if (!kpd.scanDue())
+            return false;
+
+        kpd.scanKeys();
+        settling = kpd.settleRows(kpd.activeInterval != 0);
+        return true;
+    }
+
+    // True while a row is still settling, which keeps the fast scan rate.
+    bool busy() { return settling; }
+};
+
+// Engine: Keypad's key list state machine.
+struct KeypadListEngine {
+    // Returns true if any key changed state.
+    bool commit(Keypad &kpd, bool busy) {
+        kpd.single_key = false;
+        bool keyActivity = kpd.commitFrame();
+        kpd.updateRate(busy);
+        return keyActivity;
+    }
+};
+
+template<class Source, class Engine, class... Stages> class KeypadCustomPipeline {
+public:
+    Source source;
+    KeypadStages<Stages...> stages;
+    Engine engine;
+
+    KeypadCustomPipeline(Keypad &kpd): kpd(kpd) {}
+
+    // Same return value as Keypad::getKeys().
+    bool getKeys() {
+        if (!source.scan(kpd))
+            return false;
+
+        byte numRows = kpd.sizeKpd.rows;
+        for (byte r=0; r < numRows; r++)
+            kpd.bitMap[r] = stages.row(r, kpd.bitMap[r]);
+        stages.frame(kpd.bitMap, numRows, kpd.sizeKpd.columns);
+
+        bool keyActivity = engine.commit(kpd, source.busy());
+
+        if (keyActivity)
+            kpd.forEachTransition(dispatch, &stages);
+
+        return keyActivity;
+    }
+
+private:
+    Keypad &kpd;
+
+    static void dispatch(void *stages, byte keyCode, KeyState state) {
+        ((KeypadStages<Stages...> *)stages)->event(keyCode, state);
+    }
+};
+
+template<class... Stages> class KeypadPipeline: public KeypadCustomPipeline<KeypadMatrixSource, KeypadListEngine, Stages...> {
+public:
+    KeypadPipeline(Keypad &kpd): KeypadCustomPipeline<KeypadMatrixSource, KeypadListEngine, Stages...>(kpd) {}
+};
+
+// Opposing key resolution (see KeySocd.h) with the rules fixed at compile time.
+template<KeypadSocdRule *Rules, byte Count> struct KeypadSocdStage : KeypadStage {
+    void frame(uint *rows, byte, byte numCols) {
+        keypadResolveSocd(Rules, Count, rows, numCols);
+    }
+};
+
+// Ignore some keys entirely. Masks holds one word per row, set bits are kept.
+template<const uint *Masks> struct KeypadMaskStage : KeypadStage {
+    uint row(byte r, uint cols) { return cols & Masks[r]; }
+};
+
+// Matrices without diodes show a phantom key at the fourth corner of any rectangle
+// of three closed keys. The phantom can't be told from a real key, so when two rows
+// share two or more closed columns those columns are dropped from both rows.
+struct KeypadGhostStage : KeypadStage {
+    void frame(uint *rows, byte numRows, byte) {
+        uint ghosts[KEYPAD_MAPSIZE] = {0};
+
+        for (byte a=0; a < numRows; a++) {
+            for (byte b=a+1; b < numRows; b++) {
+                uint shared = rows[a] & rows[b];
+                if (shared & (shared - 1)) {
+                    ghosts[a] |= shared;
+                    ghosts[b] |= shared;
+                }
+            }
+        }
+
+        for (byte r=0; r < numRows; r++)
+            rows[r] &= ~ghosts[r];
+    }
+};
+
+// Call a function on every transition.
+template<void (*Listener)(byte, KeyState)> struct KeypadEventSink : KeypadStage {
+    void event(byte keyCode, KeyState state) { Listener(keyCode, state); }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "KeypadSequence.h"
+
+// Blob offsets, see extras/acgen.py.
+#define AC_KEY_COUNT 3
+#define AC_STATE_COUNT 4
+#define AC_KEY_INDEX 5
+#define AC_NEXT (AC_KEY_INDEX + 128)
+
+#define AC_NO_OUTPUT 0xFF
+
+KeypadSequence::KeypadSequence(Keypad &kpd, const uint8_t *automaton): kpd(kpd) {
+    this->automaton = automaton;
+    keyCount = pgm_read_byte(automaton + AC_KEY_COUNT);
+    stateCount = pgm_read_byte(automaton + AC_STATE_COUNT);
+    timeout = 0;
+    lastKey = 0;
+    matchListener = 0;
+    reset();
+}
+
+// Called with the pattern id (NAME_LABEL from the generated header) of every match.
+void KeypadSequence::addMatchListener(void (*listener)(byte)) {
+    matchListener = listener;
+}
+
+// Start over if more than timeoutMs passes between two keys. 0 disables the timeout.
+void KeypadSequence::setTimeout(unsigned long timeoutMs) {
+    timeout = timeoutMs;
+}
+
+void KeypadSequence::reset() {
+    state = 0;
+}
+
+void KeypadSequence::feed(char key) {
+    feed(key, kpd.time_ms());
+}
+
+void KeypadSequence::feed(char key, unsigned long nowMs) {
+    if (timeout && nowMs - lastKey > timeout)
+        state = 0;
+    lastKey = nowMs;
+
+    byte column = (byte)key < 128 ? pgm_read_byte(automaton + AC_KEY_INDEX + (byte)key) : 0xFF;
+    if (column == 0xFF) {
+        // Not part of any sequence, nothing can match across it.
+        state = 0;
+        return;
+    }
+
+    state = pgm_read_byte(automaton + AC_NEXT + state * keyCount + column);
+
+    // Report the pattern ending here, then the shorter ones ending here too.
+    uint16_t outputs = AC_NEXT + stateCount * keyCount;
+    uint16_t links = outputs + stateCount;
+    byte s = state;
+
+    if (pgm_read_byte(automaton + outputs + s) == AC_NO_OUTPUT)
+        s = pgm_read_byte(automaton + links + s);
+
+    while (s != 0) {
+        if (matchListener != NULL)
+            matchListener(pgm_read_byte(automaton + outputs + s));
+        s = pgm_read_byte(automaton + links + s);
+    }
+}
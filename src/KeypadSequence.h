@@ -0,0 +1,39 @@
+#ifndef KEYPAD_SEQUENCE_H
+#define KEYPAD_SEQUENCE_H
+
+#include "Keypad.h"
+
+// Recognises key sequences (service codes, PINs, unlock combos) in the stream of
+// pressed keys. All the sequences are compiled by extras/acgen.py into a single
+// Aho-Corasick automaton in flash, so each key costs one table lookup however
+// many sequences there are, and overlapping sequences are all reported.
+//
+// Key gaps for setTimeout() are measured with the keypad's clock. Feed it from
+// a listener or after getKey():
+//
+//     void keypadEvent(char key, KeyState state) {
+//         if (state == PRESSED)
+//             sequences.feed(key);
+//     }
+class KeypadSequence {
+public:
+    KeypadSequence(Keypad &kpd, const uint8_t *automaton);
+
+    void addMatchListener(void (*listener)(byte));
+    void setTimeout(unsigned long timeoutMs);
+    void feed(char key);
+    void feed(char key, unsigned long nowMs);
+    void reset();
+
+private:
+    Keypad &kpd;
+    const uint8_t *automaton;
+    byte keyCount;
+    byte stateCount;
+    byte state;
+    unsigned long timeout;
+    unsigned long lastKey;
+    void (*matchListener)(byte);
+};
+
+#endif
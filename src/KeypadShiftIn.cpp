@@ -1,32 +1,14 @@
 #include "KeypadShiftIn.h"
 
-// Custom implementation of shiftIn that fixes the clock bug (original taken from arduino core wiring_shift.c)
-// A clock was done in the wrong way (first high then low) and the reading was done between the clocking
-uint32_t shiftIn(uint32_t ulDataPin, uint32_t ulClockPin, uint32_t ulBitOrder) {
-    uint8_t value = 0;
-    uint8_t i;
-
-    for (i=0; i < 8; ++i) {
-        digitalWrite(ulClockPin, LOW);
-
-        if (ulBitOrder == LSBFIRST)
-            value |= digitalRead(ulDataPin) << i;
-        else
-            value |= digitalRead(ulDataPin) << (7 - i);
-
-        digitalWrite(ulClockPin, HIGH);
-    }
-
-    return value;
-}
-
 KeypadShiftIn::KeypadShiftIn(const byte *row, const byte numRows, const byte numCols, uint32_t inDataPin, uint32_t inClockPin, uint32_t inLatchPin): Keypad(row, NULL, numRows, numCols) {
     this->inDataPin = inDataPin;
     this->inClockPin = inClockPin;
     this->inLatchPin = inLatchPin;
 
-    pin_write(inLatchPin, LOW);
-    pin_write(inClockPin, HIGH);
+    inProbePin = KEYPAD_NO_PIN;
+    inRegisters = (numCols + 7) / 8;
+    inProbed = false;
+    inProbeError = false;
 }
 
 void KeypadShiftIn::initColumnPins() {
@@ -36,6 +18,81 @@ void KeypadShiftIn::initColumnPins() {
 
     pin_write(inLatchPin, LOW);
     pin_write(inClockPin, HIGH);
+
+    // Only the first time: setLowPower() runs this again.
+    if (inProbePin != KEYPAD_NO_PIN && !inProbed)
+        detectInputChain();
+}
+
+// Pin wired to the serial input of the last register in the chain. With it set,
+// begin() counts the registers once instead of assuming one per 8 columns.
+void KeypadShiftIn::setInputProbePin(byte pin) {
+    inProbePin = pin;
+    inProbed = false;
+}
+
+// Flush the chain with zeros from the probe pin, then feed a single one and count
+// clocks until it comes out of the data pin: 8 per register present. Returns the
+// number of registers found. If the marker never shows up the chain is longer than
+// KEYPAD_SHIFT_MAX_REGISTERS (or broken) and the maximum is used.
+// If the data pin still reads HIGH after the flush, or the marker comes out before
+// a whole register, there is nothing to count: returns 0, keeps the register count
+// it had and getInputProbeError() is true until a probe succeeds.
+// Cheap enough to call again at runtime to check for unplugged boards.
+byte KeypadShiftIn::detectInputChain() {
+    if (inProbePin == KEYPAD_NO_PIN)
+        return inRegisters;
+
+    const byte maxBits = KEYPAD_SHIFT_MAX_REGISTERS * 8;
+    byte bits;
+
+    pin_mode(inProbePin, OUTPUT);
+    pin_write(inLatchPin, LOW);		// Stay in shift mode.
+
+    pin_write(inProbePin, LOW);
+    for (bits=0; bits < maxBits; bits++) {
+        pin_write(inClockPin, LOW);
+        pin_write(inClockPin, HIGH);
+    }
+    inProbed = true;
+    inProbeError = pin_read(inDataPin);		// Stuck HIGH, or no chain at all.
+
+    pin_write(inProbePin, HIGH);
+    for (bits=1; !inProbeError && bits <= maxBits; bits++) {
+        pin_write(inClockPin, LOW);
+        pin_write(inClockPin, HIGH);
+        if (pin_read(inDataPin))
+            break;
+    }
+    pin_write(inProbePin, LOW);
+
+    if (inProbeError || bits < 8) {
+        inProbeError = true;
+        return 0;
+    }
+
+    inRegisters = bits <= maxBits ? bits / 8 : KEYPAD_SHIFT_MAX_REGISTERS;
+    return inRegisters;
+}
+
+// Custom implementation of shiftIn that fixes the clock bug (original taken from arduino core wiring_shift.c)
+// A clock was done in the wrong way (first high then low) and the reading was done between the clocking
+// It goes through pin_read()/pin_write() so every instance stays on its own pins.
+byte KeypadShiftIn::shiftIn(byte bitOrder) {
+    byte value = 0;
+
+    for (byte i=0; i < 8; ++i) {
+        pin_write(inClockPin, LOW);
+
+        if (bitOrder == LSBFIRST)
+            value |= pin_read(inDataPin) << i;
+        else
+            value |= pin_read(inDataPin) << (7 - i);
+
+        pin_write(inClockPin, HIGH);
+    }
+
+    return value;
 }
 
 bool KeypadShiftIn::readRow(byte n) {
@@ -44,11 +101,15 @@ bool KeypadShiftIn::readRow(byte n) {
         pin_write(inLatchPin, LOW);
     }
 
+    // Don't clock registers that aren't there.
+    if ((n >> 3) >= inRegisters)
+        return false;
+
     byte ndiv = n % 8;
 
     // Handle daisy-chained shift registers
     if (ndiv == 0)
-        this->inBuffer = shiftIn(inDataPin, inClockPin, MSBFIRST);
+        this->inBuffer = shiftIn(MSBFIRST);
 
     return (this->inBuffer & (1 << ndiv)) == 0;
-}
\ No newline at end of file
+}
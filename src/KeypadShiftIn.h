@@ -6,14 +6,24 @@
 class KeypadShiftIn: virtual public Keypad {
 public:
     KeypadShiftIn(const byte *col, const byte numRows, const byte numCols, uint32_t inDataPin, uint32_t inClockPin, uint32_t inLatchPin);
+
+    void setInputProbePin(byte pin);
+    byte detectInputChain();
+    byte getInputRegisters() { return inRegisters; }
+    bool getInputProbeError() { return inProbeError; }
 private:
     uint32_t inDataPin;
     uint32_t inClockPin;
     uint32_t inLatchPin;
     uint32_t inBuffer = 0;
+    byte inProbePin;
+    byte inRegisters;
+    bool inProbed;
+    bool inProbeError;
 
     void initColumnPins();
     bool readRow(byte n);
+    byte shiftIn(byte bitOrder);
 };
 
 
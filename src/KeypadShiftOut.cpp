@@ -4,18 +4,102 @@ KeypadShiftOut::KeypadShiftOut(const byte *col, const byte numRows, const byte n
     this->outDataPin = outDataPin;
     this->outClockPin = outClockPin;
     this->outLatchPin = outLatchPin;
+
+    outProbePin = KEYPAD_NO_PIN;
+    outRegisters = (numRows + 7) / 8;
+    outProbed = false;
+    outProbeError = false;
 }
 
 void KeypadShiftOut::initRowPins() {
     pin_mode(outDataPin, OUTPUT);
     pin_mode(outClockPin, OUTPUT);
     pin_mode(outLatchPin, OUTPUT);
+
+    // Only the first time: setLowPower() runs this again.
+    if (outProbePin != KEYPAD_NO_PIN && !outProbed)
+        detectOutputChain();
+}
+
+// Input pin wired to the serial output (QH') of the last register in the chain.
+// With it set, begin() counts the registers once instead of assuming one per 8 rows.
+// Only the first KEYPAD_MAPSIZE rows of a longer chain are scanned.
+void KeypadShiftOut::setOutputProbePin(byte pin) {
+    outProbePin = pin;
+    outProbed = false;
+}
+
+// Flush the chain with zeros, shift in a single one and count clocks until it
+// comes out of QH': 8 per register present. The latch isn't touched so the row
+// outputs don't change. Returns the number of registers found. If the marker never
+// shows up the chain is longer than KEYPAD_SHIFT_MAX_REGISTERS (or broken) and the
+// maximum is used. If QH' still reads HIGH after the flush, or the marker comes out
+// before a whole register, returns 0, keeps the register count it had and
+// getOutputProbeError() is true until a probe succeeds.
+byte KeypadShiftOut::detectOutputChain() {
+    if (outProbePin == KEYPAD_NO_PIN)
+        return outRegisters;
+
+    const byte maxBits = KEYPAD_SHIFT_MAX_REGISTERS * 8;
+    byte bits;
+
+    pin_mode(outProbePin, INPUT);
+
+    pin_write(outDataPin, LOW);
+    for (bits=0; bits < maxBits; bits++) {
+        pin_write(outClockPin, HIGH);
+        pin_write(outClockPin, LOW);
+    }
+    outProbed = true;
+    outProbeError = pin_read(outProbePin);		// Stuck HIGH, or no chain at all.
+
+    pin_write(outDataPin, HIGH);
+    for (bits=1; !outProbeError && bits <= maxBits; bits++) {
+        pin_write(outClockPin, HIGH);
+        pin_write(outClockPin, LOW);
+        pin_write(outDataPin, LOW);
+        if (pin_read(outProbePin))
+            break;
+    }
+    pin_write(outDataPin, LOW);
+
+    if (outProbeError || bits < 8) {
+        outProbeError = true;
+        return 0;
+    }
+
+    outRegisters = bits <= maxBits ? bits / 8 : KEYPAD_SHIFT_MAX_REGISTERS;
+    return outRegisters;
 }
 
 void KeypadShiftOut::writeRowPre(byte n) {
+    shiftRows(1U << n);
+}
+
+void KeypadShiftOut::writeRowPost(byte) {}
+
+void KeypadShiftOut::driveRows(uint rowMask) {
+    shiftRows(rowMask);
+}
+
+// One byte per register present, the farthest register first. Rows past the end
+// of the chain are simply not driven.
+void KeypadShiftOut::shiftRows(uint rowMask) {
     pin_write(outLatchPin, LOW);
-    shiftOut(outDataPin, outClockPin, MSBFIRST, (1 << n));
+    for (byte reg = outRegisters; reg-- > 0; )
+        shiftOut(MSBFIRST, reg < sizeof(uint) ? (rowMask >> (reg * 8)) & 0xFF : 0);
     pin_write(outLatchPin, HIGH);
 }
 
-void KeypadShiftOut::writeRowPost(byte n) {}
+// Same as the arduino core shiftOut() but through pin_write(), so no global pin access.
+void KeypadShiftOut::shiftOut(byte bitOrder, byte value) {
+    for (byte i=0; i < 8; i++) {
+        if (bitOrder == LSBFIRST)
+            pin_write(outDataPin, (value >> i) & 1);
+        else
+            pin_write(outDataPin, (value >> (7 - i)) & 1);
+
+        pin_write(outClockPin, HIGH);
+        pin_write(outClockPin, LOW);
+    }
+}
@@ -6,14 +6,26 @@
 class KeypadShiftOut: virtual public Keypad {
 public:
     KeypadShiftOut(const byte *row, const byte numRows, const byte numCols, uint32_t outDataPin, uint32_t outClockPin, uint32_t outLatchPin);
+
+    void setOutputProbePin(byte pin);
+    byte detectOutputChain();
+    byte getOutputRegisters() { return outRegisters; }
+    bool getOutputProbeError() { return outProbeError; }
 private:
     uint32_t outDataPin;
     uint32_t outClockPin;
     uint32_t outLatchPin;
+    byte outProbePin;
+    byte outRegisters;
+    bool outProbed;
+    bool outProbeError;
 
     void initRowPins();
     void writeRowPre(byte n);
-    void writeRowPost(byte n);
+    void writeRowPost(byte);
+    void driveRows(uint rowMask);
+    void shiftOut(byte bitOrder, byte value);
+    void shiftRows(uint rowMask);
 };
 
 
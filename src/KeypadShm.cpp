@@ -0,0 +1,240 @@
+#if defined(__linux__)
+
+#include "KeypadShm.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define SHM_SLOT(index) ((index) & (KEYPAD_SHM_EVENTS - 1))
+
+// Creates (or takes over) the segment. Check isOpen() afterwards.
+KeypadShmPublisher::KeypadShmPublisher(const char *name, uint16_t keyCount) {
+    this->name = name;
+    shm = NULL;
+    frameMicros = 0;
+
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return;
+
+    if (ftruncate(fd, sizeof(KeypadShmLayout)) == 0) {
+        void *map = mmap(NULL, sizeof(KeypadShmLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED)
+            shm = (KeypadShmLayout *)map;
+    }
+    close(fd);
+
+    if (shm == NULL)
+        return;
+
+    uint32_t generation = 1;
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) == KEYPAD_SHM_MAGIC)
+        generation = shm->generation + 1;
+
+    __atomic_store_n(&shm->magic, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memset((void *)shm, 0, sizeof(KeypadShmLayout));
+    shm->version = KEYPAD_SHM_VERSION;
+    shm->generation = generation;
+    shm->keyCount = keyCount < KEYPAD_MAX_KEYS ? keyCount : KEYPAD_MAX_KEYS;
+    for (byte i=0; i < KEYPAD_SHM_EVENTS; i++)
+        shm->events[i].index = KEYPAD_SHM_WRITING;
+    __atomic_store_n(&shm->magic, KEYPAD_SHM_MAGIC, __ATOMIC_RELEASE);
+}
+
+// The segment stays behind for readers still mapping it, as with any shm_open().
+KeypadShmPublisher::~KeypadShmPublisher() {
+    if (shm != NULL)
+        munmap(shm, sizeof(KeypadShmLayout));
+}
+
+// Call right after a getKeys() that returned true: the frame's transitions are read
+// from keysPressed/keysHeld/keysReleased, which only hold the latest frame.
+void KeypadShmPublisher::publish(Keypad &kpd) {
+    if (shm == NULL)
+        return;
+
+    frameMicros = kpd.time_us();
+    uint32_t seq = shm->seq;
+
+    __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (byte w=0; w < KEYPAD_BITMAP_WORDS; w++)
+        __atomic_store_n(&shm->down[w], kpd.keysDown.words[w], __ATOMIC_RELAXED);
+
+    for (uint16_t k=0; k < shm->keyCount; k++)
+        __atomic_store_n(&shm->states[k], (uint8_t)IDLE, __ATOMIC_RELAXED);
+    for (byte i=0; i < KEYPAD_LIST_MAX; i++) {
+        if (kpd.key[i].kchar != KEYPAD_NO_KEY && kpd.key[i].kcode >= 0 && kpd.key[i].kcode < shm->keyCount)
+            __atomic_store_n(&shm->states[kpd.key[i].kcode], (uint8_t)kpd.key[i].kstate, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&shm->seq, seq + 2, __ATOMIC_RELEASE);
+
+    kpd.forEachTransition(transition, this);
+}
+
+// Every event of a frame carries the time it was published.
+void KeypadShmPublisher::transition(void *context, byte keyCode, KeyState state) {
+    KeypadShmPublisher *publisher = (KeypadShmPublisher *)context;
+    publisher->event(keyCode, state, publisher->frameMicros);
+}
+
+// The slot is marked invalid before its fields change, so a reader copying it at the
+// same time sees the index change and drops the copy.
+void KeypadShmPublisher::event(byte keyCode, KeyState state, uint32_t micros) {
+    uint32_t index = shm->head;
+    KeypadShmEvent &slot = shm->events[SHM_SLOT(index)];
+
+    __atomic_store_n(&slot.index, KEYPAD_SHM_WRITING, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot.micros, micros, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.keyCode, keyCode, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.state, (uint8_t)state, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot.index, index, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm->head, index + 1, __ATOMIC_RELEASE);
+}
+
+// Maps an existing segment read only. Starts at the oldest event still in the ring.
+KeypadShmReader::KeypadShmReader(const char *name) {
+    shm = NULL;
+    generation = 0;
+    cursor = 0;
+    lost = 0;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return;
+
+    void *map = mmap(NULL, sizeof(KeypadShmLayout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return;
+
+    shm = (const KeypadShmLayout *)map;
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != KEYPAD_SHM_MAGIC || shm->version != KEYPAD_SHM_VERSION) {
+        munmap((void *)shm, sizeof(KeypadShmLayout));
+        shm = NULL;
+        return;
+    }
+
+    sync();
+}
+
+KeypadShmReader::~KeypadShmReader() {
+    if (shm != NULL)
+        munmap((void *)shm, sizeof(KeypadShmLayout));
+}
+
+uint16_t KeypadShmReader::keyCount() {
+    return shm != NULL ? shm->keyCount : 0;
+}
+
+// Private : Follow a publisher restart. If the generation changed, or the cursor is
+// past head (which only a new generation can cause), start again at the oldest event
+// in the ring. Returns false while the segment is being reset.
+bool KeypadShmReader::sync() {
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != KEYPAD_SHM_MAGIC)
+        return false;
+
+    uint32_t gen = __atomic_load_n(&shm->generation, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&shm->head, __ATOMIC_ACQUIRE);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&shm->magic, __ATOMIC_RELAXED) != KEYPAD_SHM_MAGIC ||
+            __atomic_load_n(&shm->generation, __ATOMIC_RELAXED) != gen)
+        return false;
+
+    if (gen != generation || (int32_t)(head - cursor) < 0) {
+        generation = gen;
+        cursor = head > KEYPAD_SHM_EVENTS ? head - KEYPAD_SHM_EVENTS : 0;
+    }
+    return true;
+}
+
+// Private : After copying from the segment, true if it wasn't reset meanwhile.
+bool KeypadShmReader::current() {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&shm->magic, __ATOMIC_RELAXED) == KEYPAD_SHM_MAGIC &&
+            __atomic_load_n(&shm->generation, __ATOMIC_RELAXED) == generation;
+}
+
+// Copy the pressed bitmap and, if states isn't NULL, keyCount() per-key states.
+// Gives up and returns false if the publisher kept changing them for all tries, so
+// the call is bounded no matter what the writer does.
+bool KeypadShmReader::snapshot(KeyBitmap &down, uint8_t *states, byte tries) {
+    if (shm == NULL)
+        return false;
+
+    while (tries--) {
+        if (!sync())
+            continue;
+
+        uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue;
+
+        for (byte w=0; w < KEYPAD_BITMAP_WORDS; w++)
+            down.words[w] = __atomic_load_n(&shm->down[w], __ATOMIC_RELAXED);
+        for (uint16_t k=0; states != NULL && k < shm->keyCount; k++)
+            states[k] = __atomic_load_n(&shm->states[k], __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == seq && current())
+            return true;
+    }
+
+    return false;
+}
+
+// Take this reader's next event. Returns false when it has caught up.
+bool KeypadShmReader::readEvent(KeypadShmEvent &event) {
+    if (shm == NULL)
+        return false;
+
+    for (;;) {
+        if (!sync())
+            return false;
+
+        uint32_t head = __atomic_load_n(&shm->head, __ATOMIC_ACQUIRE);
+        if (!current())
+            continue;
+        if (cursor == head)
+            return false;
+
+        if (head - cursor > KEYPAD_SHM_EVENTS) {
+            lost += head - cursor - KEYPAD_SHM_EVENTS;
+            cursor = head - KEYPAD_SHM_EVENTS;
+        }
+
+        const KeypadShmEvent &slot = shm->events[SHM_SLOT(cursor)];
+        if (__atomic_load_n(&slot.index, __ATOMIC_ACQUIRE) == cursor) {
+            event.index = cursor;
+            event.micros = __atomic_load_n(&slot.micros, __ATOMIC_RELAXED);
+            event.keyCode = __atomic_load_n(&slot.keyCode, __ATOMIC_RELAXED);
+            event.state = __atomic_load_n(&slot.state, __ATOMIC_RELAXED);
+
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot.index, __ATOMIC_RELAXED) == cursor) {
+                if (!current())
+                    continue;		// Reset while we looked, sync() starts over.
+                cursor++;
+                return true;
+            }
+        }
+
+        if (!current())
+            continue;
+
+        // Overwritten while we looked, the writer is a full ring ahead: skip it.
+        lost++;
+        cursor++;
+    }
+}
+
+#endif
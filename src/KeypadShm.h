@@ -0,0 +1,94 @@
+#ifndef KEYPAD_SHM_H
+#define KEYPAD_SHM_H
+
+#if defined(__linux__)
+
+#include "Keypad.h"
+
+#define KEYPAD_SHM_MAGIC 0x4B50534DUL	// "KPSM"
+#define KEYPAD_SHM_VERSION 2
+#define KEYPAD_SHM_EVENTS 64			// Power of two.
+#define KEYPAD_SHM_WRITING 0xFFFFFFFFUL	// Event index while the slot is being written.
+
+typedef struct {
+    uint32_t index;			// Event number, KEYPAD_SHM_WRITING while the slot changes.
+    uint32_t micros;		// time_us() of the scan that produced it.
+    uint8_t keyCode;
+    uint8_t state;			// PRESSED, HOLD or RELEASED.
+    uint8_t reserved[2];
+} KeypadShmEvent;
+
+// The shared memory segment. Fixed layout, no pointers, so every process can map
+// it at any address.
+typedef struct {
+    uint32_t magic;			// Written last by the publisher, once the rest is valid.
+    uint16_t version;
+    uint16_t keyCount;
+    uint32_t generation;	// Counts publishers that have taken over the segment.
+    uint32_t seq;			// Seqlock over down[] and states[]: odd while they change.
+    uint32_t down[KEYPAD_BITMAP_WORDS];
+    uint8_t states[KEYPAD_MAX_KEYS];	// KeyState per key code.
+    uint32_t head;			// Events written so far.
+    KeypadShmEvent events[KEYPAD_SHM_EVENTS];
+} KeypadShmLayout;
+
+// Publishes a keypad's debounced state to other processes through POSIX shared
+// memory (/dev/shm/<name>). There is one writer, the scanning process:
+//
+//     KeypadShmPublisher shm("/keypad", ROWS * COLS);
+//     ...
+//     if (kpd.getKeys())
+//         shm.publish(kpd);
+//
+// Readers (KeypadShmReader) map the segment read only and never block the writer
+// or each other. The pressed bitmap and per-key states are a seqlock protected
+// snapshot. Events go to a ring that every reader walks with its own cursor; a
+// reader that falls more than KEYPAD_SHM_EVENTS behind loses the oldest events and
+// is told how many.
+//
+// A publisher that restarts takes the segment over, starting a new generation with
+// an empty ring. Readers keep their mapping: they see no events or snapshot while
+// the segment is being reset, then move to the oldest event of the new generation.
+class KeypadShmPublisher {
+public:
+    KeypadShmPublisher(const char *name, uint16_t keyCount);
+    ~KeypadShmPublisher();
+
+    bool isOpen() { return shm != NULL; }
+    void publish(Keypad &kpd);
+
+private:
+    const char *name;
+    KeypadShmLayout *shm;
+
+    uint32_t frameMicros;
+
+    void event(byte keyCode, KeyState state, uint32_t micros);
+    static void transition(void *context, byte keyCode, KeyState state);
+};
+
+class KeypadShmReader {
+public:
+    KeypadShmReader(const char *name);
+    ~KeypadShmReader();
+
+    bool isOpen() { return shm != NULL; }
+    uint16_t keyCount();
+    bool snapshot(KeyBitmap &down, uint8_t *states = NULL, byte tries = 8);
+    bool readEvent(KeypadShmEvent &event);
+    uint32_t getLostEvents() { return lost; }
+    uint32_t getGeneration() { return generation; }
+
+private:
+    const KeypadShmLayout *shm;
+    uint32_t generation;
+    uint32_t cursor;
+    uint32_t lost;
+
+    bool sync();
+    bool current();
+};
+
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+#include "KeypadStream.h"
+
+KeypadStream::KeypadStream(Keypad &keypad): keypad(keypad) {
+    repeatDelay = 0;
+    repeatInterval = 0;
+    repeatCode = -1;
+    nextRepeat = 0;
+    head = 0;
+    count = 0;
+}
+
+// Scan the keypad and queue anything that was pressed. Called by every read,
+// but can also be called from loop() to keep buffering while the sketch is busy.
+void KeypadStream::update() {
+    if (keypad.getKeys())
+        keypad.forEachTransition(transition, this);
+
+    if (repeatCode < 0)
+        return;
+
+    unsigned long now = keypad.time_ms();
+    if ((long)(now - nextRepeat) < 0)
+        return;
+
+    push(repeatCode);
+    // A sketch that was busy gets one repeat, not a burst of them.
+    nextRepeat = now - nextRepeat < repeatInterval ? nextRepeat + repeatInterval : now + repeatInterval;
+}
+
+// Auto-repeat: once the last key pressed has been held for delayMs, queue it again
+// every intervalMs until it is released. An interval of 0 turns repeat off.
+void KeypadStream::setRepeat(uint delayMs, uint intervalMs) {
+    repeatDelay = delayMs;
+    repeatInterval = intervalMs;
+    repeatCode = -1;
+}
+
+void KeypadStream::transition(void *context, byte keyCode, KeyState state) {
+    KeypadStream &s = *(KeypadStream *)context;
+
+    if (state == PRESSED) {
+        s.push(keyCode);
+        if (s.repeatInterval) {
+            s.repeatCode = keyCode;
+            s.nextRepeat = s.keypad.time_ms() + s.repeatDelay;
+        }
+    } else if (state == RELEASED && keyCode == s.repeatCode) {
+        s.repeatCode = -1;
+    }
+}
+
+// Characters that don't fit are dropped, like a full serial receive buffer.
+void KeypadStream::push(byte keyCode) {
+    if (count == KEYPAD_STREAM_BUFFER)
+        return;
+
+    buffer[(head + count) & (KEYPAD_STREAM_BUFFER - 1)] = keypad.getKeyChar(keyCode);
+    count++;
+}
+
+int KeypadStream::available() {
+    update();
+    return count;
+}
+
+int KeypadStream::read() {
+    update();
+    if (count == 0)
+        return -1;
+
+    char c = buffer[head];
+    head = (head + 1) & (KEYPAD_STREAM_BUFFER - 1);
+    count--;
+    return (byte)c;
+}
+
+int KeypadStream::peek() {
+    update();
+    return count ? (byte)buffer[head] : -1;
+}
@@ -0,0 +1,40 @@
+#ifndef KEYPAD_STREAM_H
+#define KEYPAD_STREAM_H
+
+#include "Keypad.h"
+
+#define KEYPAD_STREAM_BUFFER 16		// Characters buffered between reads. Must be a power of 2.
+
+// Presents a keypad as a read-only Stream, so parseInt(), readBytesUntil() and
+// friends can consume key presses directly. Every read scans the keypad and
+// queues the characters of keys that went PRESSED, so nothing pressed between
+// reads is lost until the buffer fills. With setRepeat() the last key pressed
+// repeats like on a PC keyboard for as long as it is held.
+class KeypadStream : public Stream {
+public:
+    KeypadStream(Keypad &keypad);
+
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t) { return 0; }
+    void flush() {}
+
+    void update();
+    void setRepeat(uint delayMs, uint intervalMs);
+
+private:
+    Keypad &keypad;
+    uint repeatDelay;
+    uint repeatInterval;
+    int repeatCode;
+    unsigned long nextRepeat;
+    char buffer[KEYPAD_STREAM_BUFFER];
+    byte head;
+    byte count;
+
+    void push(byte keyCode);
+    static void transition(void *context, byte keyCode, KeyState state);
+};
+
+#endif
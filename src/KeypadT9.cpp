@@ -0,0 +1,83 @@
+#include "KeypadT9.h"
+
+#define T9_ROOT 3		// After the 'T' '9' version header.
+
+static const char t9Letters[8][5] PROGMEM = {
+    "abc", "def", "ghi", "jkl", "mno", "pqrs", "tuv", "wxyz"
+};
+
+KeypadT9::KeypadT9(const uint8_t *dictionary) {
+    dict = dictionary;
+    reset();
+}
+
+void KeypadT9::reset() {
+    path[0] = T9_ROOT;
+    depth = 0;
+    selected = 0;
+}
+
+uint16_t KeypadT9::readWord(uint16_t offset) {
+    return pgm_read_byte(dict + offset) | (pgm_read_byte(dict + offset + 1) << 8);
+}
+
+// Follow the child for digit. Returns false, and stays put, if no word goes on that way.
+bool KeypadT9::press(char digit) {
+    if (digit < '2' || digit > '9' || depth >= KEYPAD_T9_MAX_WORD)
+        return false;
+
+    byte bit = digit - '2';
+    byte mask = pgm_read_byte(dict + path[depth]);
+    if (!bitRead(mask, bit))
+        return false;
+
+    // Children are stored in digit order, so the slot is the number of lower digits present.
+    byte slot = __builtin_popcount(mask & ((1 << bit) - 1));
+    path[depth + 1] = readWord(path[depth] + 2 + 2 * slot);
+    digits[depth] = digit;
+    depth++;
+    selected = 0;
+    return true;
+}
+
+void KeypadT9::backspace() {
+    if (depth > 0)
+        depth--;
+    selected = 0;
+}
+
+// Cycle through the candidates, wrapping around at either end.
+void KeypadT9::next() {
+    byte n = candidates();
+    if (n)
+        selected = (selected + 1) % n;
+}
+
+void KeypadT9::prev() {
+    byte n = candidates();
+    if (n)
+        selected = (selected + n - 1) % n;
+}
+
+byte KeypadT9::candidates() {
+    return depth ? pgm_read_byte(dict + path[depth] + 1) : 0;
+}
+
+// Copy the selected candidate into buffer as a C string. Returns false if there is
+// none or it doesn't fit.
+bool KeypadT9::candidate(char *buffer, byte size) {
+    if (candidates() == 0 || size <= depth)
+        return false;
+
+    uint16_t node = path[depth];
+    byte mask = pgm_read_byte(dict + node);
+    byte wordBytes = (depth + 3) / 4;
+    uint16_t word = node + 2 + 2 * __builtin_popcount(mask) + selected * wordBytes;
+
+    for (byte i=0; i < depth; i++) {
+        byte letter = (pgm_read_byte(dict + word + i / 4) >> ((i % 4) * 2)) & 3;
+        buffer[i] = pgm_read_byte(&t9Letters[digits[i] - '2'][letter]);
+    }
+    buffer[depth] = '\0';
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef KEYPAD_T9_H
+#define KEYPAD_T9_H
+
+#include "Keypad.h"
+
+#define KEYPAD_T9_MAX_WORD 16	// Longest digit sequence that can be typed.
+
+// Predictive text for phone keypads. Each digit '2'..'9' moves one level down a
+// digit trie kept in flash, so a key press costs the same no matter how large the
+// dictionary is. The words at the current node are the candidates, most frequent
+// first. Dictionaries are generated with extras/t9dict.py, which also documents
+// the blob layout and its size limit: node offsets are 16 bit, so a dictionary is
+// at most 64 KiB, around 5000 words (32 KiB on AVR). extras/host/t9bench.cpp times
+// press() and next()/prev() on the host.
+class KeypadT9 {
+public:
+    KeypadT9(const uint8_t *dictionary);
+
+    bool press(char digit);
+    void backspace();
+    void reset();
+
+    void next();
+    void prev();
+    byte candidates();
+    bool candidate(char *buffer, byte size);
+    byte length() { return depth; }
+
+private:
+    const uint8_t *dict;
+    uint16_t path[KEYPAD_T9_MAX_WORD + 1];	// Node offsets from the root down.
+    char digits[KEYPAD_T9_MAX_WORD];
+    byte depth;
+    byte selected;
+
+    uint16_t readWord(uint16_t offset);
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "KeypadTiming.h"
+
+#define KEYPAD_TIMING_NO_KEY 0xFF
+
+KeypadTiming::KeypadTiming() {
+    for (byte s=0; s < KEYPAD_TIMING_STAMPS; s++) {
+        stampKeys[s] = KEYPAD_TIMING_NO_KEY;
+        stampMicros[s] = 0;
+        reverted[s] = false;
+        revertMicros[s] = 0;
+    }
+    nextStamp = 0;
+    for (byte i=0; i < KEYPAD_LIST_MAX; i++)
+        pressMicros[i] = 0;
+    clear();
+}
+
+// Drop the records and restart the error bound.
+void KeypadTiming::clear() {
+    head = 0;
+    count = 0;
+    released = false;
+    lastFrame = 0;
+    maxPeriod = 0;
+}
+
+byte KeypadTiming::available() {
+    return count;
+}
+
+// Take the oldest record. Returns false if there are none.
+bool KeypadTiming::read(KeypadTimingRecord &record) {
+    if (count == 0)
+        return false;
+
+    record = ring[(head + KEYPAD_TIMING_RECORDS - count) % KEYPAD_TIMING_RECORDS];
+    count--;
+    return true;
+}
+
+// Longest time between two scans since clear(), the worst case lateness of a stamp.
+unsigned long KeypadTiming::getErrorBound() {
+    return maxPeriod;
+}
+
+void KeypadTiming::frame(unsigned long nowMicros) {
+    if (lastFrame != 0 && nowMicros - lastFrame > maxPeriod)
+        maxPeriod = nowMicros - lastFrame;
+    lastFrame = nowMicros;
+}
+
+// Stamp the keys of a row that changed. A key keeps the first stamp taken since its
+// last transition while it bounces. The stamp is dropped once the raw bit has been
+// back in the committed state for bounceMicros (the keypad's debounceTime), so an
+// edge that didn't stick doesn't date the next one.
+void KeypadTiming::rowChanged(byte firstKey, uint changed, uint closed, unsigned long nowMicros,
+        unsigned long bounceMicros) {
+    while (changed) {
+        byte bit = __builtin_ctz(changed);
+        byte keyCode = firstKey + bit;
+        bool pending = bitRead(closed, bit) != down.test(keyCode);
+        changed &= changed - 1;
+
+        byte s, free = KEYPAD_TIMING_STAMPS;
+        for (s=0; s < KEYPAD_TIMING_STAMPS; s++) {
+            if (stampKeys[s] != KEYPAD_TIMING_NO_KEY && reverted[s] && nowMicros - revertMicros[s] >= bounceMicros)
+                stampKeys[s] = KEYPAD_TIMING_NO_KEY;
+            if (stampKeys[s] == keyCode)
+                break;
+            if (free == KEYPAD_TIMING_STAMPS && stampKeys[s] == KEYPAD_TIMING_NO_KEY)
+                free = s;
+        }
+
+        if (!pending) {
+            // Back where it was committed: noise or bounce, decided by how long it stays.
+            if (s < KEYPAD_TIMING_STAMPS) {
+                reverted[s] = true;
+                revertMicros[s] = nowMicros;
+            }
+            continue;
+        }
+
+        if (s == KEYPAD_TIMING_STAMPS) {
+            if (free == KEYPAD_TIMING_STAMPS) {
+                free = nextStamp;
+                nextStamp = (nextStamp + 1) % KEYPAD_TIMING_STAMPS;
+            }
+            s = free;
+            stampKeys[s] = keyCode;
+            stampMicros[s] = nowMicros;
+        }
+        reverted[s] = false;
+    }
+}
+
+void KeypadTiming::edge(byte slot, byte keyCode, KeyState state) {
+    unsigned long stamp = lastFrame;
+    KeypadTimingRecord &record = ring[head];
+
+    for (byte s=0; s < KEYPAD_TIMING_STAMPS; s++) {
+        if (stampKeys[s] == keyCode) {
+            stamp = stampMicros[s];
+            stampKeys[s] = KEYPAD_TIMING_NO_KEY;
+            break;
+        }
+    }
+
+    record.keyCode = keyCode;
+    record.edge = state;
+    record.micros = stamp;
+
+    if (state == PRESSED) {
+        down.set(keyCode);
+        record.interval = released ? stamp - lastRelease : 0;
+        pressMicros[slot] = stamp;
+    } else {
+        down.reset(keyCode);
+        record.interval = stamp - pressMicros[slot];
+        lastRelease = stamp;
+        released = true;
+    }
+
+    if (++head == KEYPAD_TIMING_RECORDS)
+        head = 0;
+    if (count < KEYPAD_TIMING_RECORDS)
+        count++;
+}
@@ -0,0 +1,73 @@
+#ifndef KEYPAD_TIMING_H
+#define KEYPAD_TIMING_H
+
+#include "Keypad.h"
+
+#ifndef KEYPAD_TIMING_RECORDS
+#define KEYPAD_TIMING_RECORDS 16
+#endif
+
+// Keys whose raw edge can wait for its transition at the same time.
+#ifndef KEYPAD_TIMING_STAMPS
+#define KEYPAD_TIMING_STAMPS 8
+#endif
+
+typedef struct {
+    byte keyCode;
+    byte edge;				// PRESSED or RELEASED.
+    unsigned long micros;	// time_us() of the row strobe that saw the key change.
+    unsigned long interval;	// PRESSED: flight time since the previous release of any key (0 for the first).
+                            // RELEASED: dwell time since this key was pressed.
+} KeypadTimingRecord;
+
+// Microsecond press/release timestamps for keystroke dynamics. Attach it with
+// Keypad::setTiming(). Every key whose bit differs from the previous scan is stamped
+// with time_us() of the row strobe that read it, and the PRESSED and RELEASED
+// transitions that follow are written to a ring of KeypadTimingRecord, oldest
+// overwritten first. Stamps are kept per key, so another key changing on the same
+// row before the transition doesn't move it. A key keeps its first stamp while it
+// bounces, and loses it once it has been back in its last committed state for
+// debounceTime. Up to KEYPAD_TIMING_STAMPS keys can wait for their transition at
+// once; past that the oldest stamp is reused and its key falls back to the time of
+// its frame.
+//
+// A stamp is taken when the edge is seen, not when it happened: it lands somewhere
+// in the previous scan period, so every timestamp is late by up to one scan period
+// and dwell and flight times are off by up to one period either way. A bouncing
+// contact can add up to its bounce time when a scan at setScanRate()'s idle rate
+// samples it open mid-bounce. getErrorBound() returns the longest period seen
+// since clear(). Scan often (a short debounceTime and a tight loop) to keep it
+// small; the cost per scan is one compare per row plus one time_us() and a short
+// table walk per row that changed.
+class KeypadTiming {
+public:
+    KeypadTiming();
+
+    byte available();
+    bool read(KeypadTimingRecord &record);
+    unsigned long getErrorBound();
+    void clear();
+
+    // Called by Keypad.
+    void frame(unsigned long nowMicros);
+    void rowChanged(byte firstKey, uint changed, uint closed, unsigned long nowMicros, unsigned long bounceMicros);
+    void edge(byte slot, byte keyCode, KeyState state);
+
+private:
+    KeypadTimingRecord ring[KEYPAD_TIMING_RECORDS];
+    byte head;		// Next record to write.
+    byte count;
+    byte stampKeys[KEYPAD_TIMING_STAMPS];		// KEYPAD_TIMING_NO_KEY when free.
+    unsigned long stampMicros[KEYPAD_TIMING_STAMPS];
+    bool reverted[KEYPAD_TIMING_STAMPS];		// The raw bit went back to the committed state...
+    unsigned long revertMicros[KEYPAD_TIMING_STAMPS];		// ...at this time.
+    byte nextStamp;		// Reused when none is free.
+    unsigned long pressMicros[KEYPAD_LIST_MAX];		// By key list slot.
+    KeyBitmap down;		// Committed state: PRESSED until RELEASED.
+    unsigned long lastRelease;
+    bool released;
+    unsigned long lastFrame;
+    unsigned long maxPeriod;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "KeypadVcd.h"
+
+// Levels besides LOW and HIGH.
+#define VCD_UNKNOWN 2
+#define VCD_FLOATING 3
+
+// Pin mode before the first pin_mode(): writes are shown as they happen.
+#define VCD_MODE_UNKNOWN 0xFF
+
+KeypadVcd::KeypadVcd(Print &out): out(out) {
+    count = 0;
+    started = false;
+    lastMicros = 0;
+}
+
+// Declare a pin to trace. Must be called before begin(), VCD has no way to add
+// signals once the dump starts. Pins that aren't declared are ignored.
+bool KeypadVcd::addPin(byte pin, const char *name) {
+    if (started || count >= KEYPAD_VCD_MAX_PINS || find(pin) >= 0)
+        return false;
+
+    pins[count] = pin;
+    names[count] = name;
+    levels[count] = VCD_UNKNOWN;
+    latched[count] = LOW;
+    modes[count] = VCD_MODE_UNKNOWN;
+    edges[count] = 0;
+    redundant[count] = 0;
+    count++;
+    return true;
+}
+
+// Write the header and the initial (unknown) values.
+void KeypadVcd::begin() {
+    out.print("$timescale 1us $end\n$scope module keypad $end\n");
+    for (byte i=0; i < count; i++) {
+        out.print("$var wire 1 ");
+        out.write('!' + i);
+        out.print(' ');
+        if (names[i] != NULL) {
+            out.print(names[i]);
+        } else {
+            out.print("pin");
+            out.print(pins[i]);
+        }
+        out.print(" $end\n");
+    }
+    out.print("$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+    for (byte i=0; i < count; i++)
+        printValue(i);
+    out.print("$end\n");
+
+    started = true;
+}
+
+// A write to a plain input only sets the level it will drive as an output. On a
+// pulled-up input it switches the pull-up, as on AVR where one register holds both:
+// LOW turns it off and the pin floats.
+void KeypadVcd::write(byte pin, byte level, unsigned long micros) {
+    int8_t idx = find(pin);
+
+    if (idx < 0)
+        return;
+
+    level = level ? HIGH : LOW;
+    if (modes[idx] == INPUT_PULLUP) {
+        latched[idx] = level;
+        if (level == HIGH) {
+            redundant[idx]++;
+            return;
+        }
+        modes[idx] = INPUT;
+        if (levels[idx] != VCD_FLOATING)
+            change(idx, VCD_FLOATING, micros);
+        return;
+    }
+    if (modes[idx] == INPUT) {
+        if (latched[idx] == level)
+            redundant[idx]++;
+        latched[idx] = level;
+        return;
+    }
+
+    latched[idx] = level;
+    if (levels[idx] == level) {
+        redundant[idx]++;
+        return;
+    }
+
+    change(idx, level, micros);
+}
+
+// Inputs show the level that was sampled.
+void KeypadVcd::read(byte pin, byte level, unsigned long micros) {
+    int8_t idx = find(pin);
+
+    if (idx >= 0 && levels[idx] != (level ? HIGH : LOW))
+        change(idx, level ? HIGH : LOW, micros);
+}
+
+// Plain inputs float until read, pull-ups hold the line high and outputs drive the
+// last level written.
+void KeypadVcd::mode(byte pin, byte mode, unsigned long micros) {
+    int8_t idx = find(pin);
+
+    if (idx < 0)
+        return;
+
+    modes[idx] = mode;
+
+    byte level;
+    if (mode == INPUT)
+        level = VCD_FLOATING;
+    else if (mode == INPUT_PULLUP)
+        level = HIGH;
+    else
+        level = latched[idx];
+
+    if (levels[idx] != level)
+        change(idx, level, micros);
+}
+
+// Level changes recorded for a pin.
+unsigned long KeypadVcd::getEdges(byte pin) {
+    int8_t idx = find(pin);
+    return idx >= 0 ? edges[idx] : 0;
+}
+
+// Writes that left a pin at the level it already had.
+unsigned long KeypadVcd::getRedundantWrites(byte pin) {
+    int8_t idx = find(pin);
+    return idx >= 0 ? redundant[idx] : 0;
+}
+
+int8_t KeypadVcd::find(byte pin) {
+    for (byte i=0; i < count; i++) {
+        if (pins[i] == pin)
+            return i;
+    }
+    return -1;
+}
+
+void KeypadVcd::change(int8_t idx, byte level, unsigned long micros) {
+    levels[idx] = level;
+    edges[idx]++;
+
+    if (!started)
+        return;
+
+    if (micros != lastMicros) {
+        out.write('#');
+        out.print(micros);
+        out.write('\n');
+        lastMicros = micros;
+    }
+    printValue(idx);
+}
+
+void KeypadVcd::printValue(int8_t idx) {
+    static const char values[] = { '0', '1', 'x', 'z' };
+
+    out.write(values[levels[idx]]);
+    out.write('!' + idx);
+    out.write('\n');
+}
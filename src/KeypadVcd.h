@@ -0,0 +1,49 @@
+#ifndef KEYPAD_VCD_H
+#define KEYPAD_VCD_H
+
+#include "Keypad.h"
+
+#define KEYPAD_VCD_MAX_PINS 32
+
+// Writes pin activity as a Value Change Dump (VCD) that GTKWave and other waveform
+// viewers can open. Attach it with Keypad::setPinTrace() to record every pin_write(),
+// pin_read() and pin_mode() the keypad does, stamped with time_us(). The library
+// must be built with KEYPAD_PIN_TRACE 1. Meant for an emulator, where time_us() is
+// simulated and the output is a file; on real hardware printing the trace slows the
+// scan down a lot.
+//
+// Writes that don't change the level aren't dumped. They are counted, so redundant
+// clock/latch/row edges can be spotted when optimising a backend.
+class KeypadVcd {
+public:
+    KeypadVcd(Print &out);
+
+    bool addPin(byte pin, const char *name = NULL);
+    void begin();
+
+    void write(byte pin, byte level, unsigned long micros);
+    void read(byte pin, byte level, unsigned long micros);
+    void mode(byte pin, byte mode, unsigned long micros);
+
+    unsigned long getEdges(byte pin);
+    unsigned long getRedundantWrites(byte pin);
+
+private:
+    Print &out;
+    byte count;
+    bool started;
+    unsigned long lastMicros;
+    byte pins[KEYPAD_VCD_MAX_PINS];
+    const char *names[KEYPAD_VCD_MAX_PINS];
+    byte levels[KEYPAD_VCD_MAX_PINS];
+    byte latched[KEYPAD_VCD_MAX_PINS];		// Last level written, driven once the pin is an OUTPUT.
+    byte modes[KEYPAD_VCD_MAX_PINS];
+    unsigned long edges[KEYPAD_VCD_MAX_PINS];
+    unsigned long redundant[KEYPAD_VCD_MAX_PINS];
+
+    int8_t find(byte pin);
+    void change(int8_t idx, byte level, unsigned long micros);
+    void printValue(int8_t idx);
+};
+
+#endif
@@ -33,6 +33,7 @@
 // default constructor
 Key::Key() {
 	kchar = KEYPAD_NO_KEY;
+	kcode = KEYPAD_UNASSIGNED;
 	kstate = IDLE;
 	stateChanged = false;
 }
@@ -0,0 +1,75 @@
+#ifndef KEYBITMAP_H
+#define KEYBITMAP_H
+
+// Arduino versioning.
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+// Number of keys a bitmap can hold. Keypad.h sizes it from bitMap[] before including us.
+#ifndef KEYPAD_MAX_KEYS
+#define KEYPAD_MAX_KEYS 160
+#endif
+
+#define KEYPAD_BITMAP_WORDS ((KEYPAD_MAX_KEYS + 31) / 32)
+
+// One bit per key code (row * columns + column).
+class KeyBitmap {
+public:
+    uint32_t words[KEYPAD_BITMAP_WORDS];
+
+    KeyBitmap() { clear(); }
+
+    void clear() {
+        for (byte i=0; i < KEYPAD_BITMAP_WORDS; i++)
+            words[i] = 0;
+    }
+
+    void set(byte keyCode) { words[keyCode >> 5] |= (uint32_t)1 << (keyCode & 31); }
+    void reset(byte keyCode) { words[keyCode >> 5] &= ~((uint32_t)1 << (keyCode & 31)); }
+    bool test(byte keyCode) const { return (words[keyCode >> 5] >> (keyCode & 31)) & 1; }
+
+    bool any() const {
+        for (byte i=0; i < KEYPAD_BITMAP_WORDS; i++)
+            if (words[i]) return true;
+        return false;
+    }
+
+    byte count() const {
+        byte n = 0;
+        for (byte i=0; i < KEYPAD_BITMAP_WORDS; i++)
+            n += __builtin_popcountl(words[i]);
+        return n;
+    }
+};
+
+// Walks the set bits of a bitmap, lowest key code first, in O(set bits + words).
+//
+//     KeyBitmapIterator it(kpd.keysPressed);
+//     int code;
+//     while ((code = it.next()) >= 0) { ... }
+class KeyBitmapIterator {
+public:
+    KeyBitmapIterator(const KeyBitmap &map): map(map), word(0), bits(map.words[0]) {}
+
+    // Returns the next key code or -1 when there are no more.
+    int next() {
+        while (bits == 0) {
+            if (++word >= KEYPAD_BITMAP_WORDS) return -1;
+            bits = map.words[word];
+        }
+
+        byte bit = __builtin_ctzl(bits);
+        bits &= bits - 1;	// Drop the lowest set bit.
+        return (word << 5) + bit;
+    }
+
+private:
+    const KeyBitmap &map;
+    byte word;
+    uint32_t bits;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "KeySharedPins.h"
+
+#if defined(__AVR__)
+
+// Rows idle as driven HIGH outputs, or tri-stated LOW in low power mode so that
+// writeRowPre() only has to flip them to OUTPUT. Columns are always pulled up.
+bool KeySharedPins::build(const byte *rowPins, byte rows, const byte *colPins, byte cols, bool lowPower) {
+    ports = 0;
+
+    for (byte r=0; r < rows; r++)
+        if (!addPin(rowPins[r], !lowPower, !lowPower))
+            return false;
+
+    for (byte c=0; c < cols; c++)
+        if (!addPin(colPins[c], false, true))
+            return false;
+
+    return true;
+}
+
+bool KeySharedPins::addPin(byte pin, bool output, bool level) {
+    uint8_t p = digitalPinToPort(pin);
+    if (p == NOT_A_PIN) {
+        ports = 0;
+        return false;
+    }
+
+    volatile uint8_t *ddr = portModeRegister(p);
+    uint8_t bit = digitalPinToBitMask(pin);
+    byte i = 0;
+
+    while (i < ports && port[i].ddr != ddr)
+        i++;
+
+    if (i == ports) {
+        if (ports == KEYPAD_SHARED_PORTS) {
+            ports = 0;
+            return false;
+        }
+        port[i].ddr = ddr;
+        port[i].out = portOutputRegister(p);
+        port[i].mask = port[i].ddrScan = port[i].outScan = 0;
+        ports++;
+    }
+
+    port[i].mask |= bit;
+    if (output)
+        port[i].ddrScan |= bit;
+    if (level)
+        port[i].outScan |= bit;
+    return true;
+}
+
+// Inputs are released before the output latch changes and outputs are enabled
+// last, so no pin is ever driven to a level that belongs to the other peripheral.
+void KeySharedPins::claim() {
+    uint8_t sreg = SREG;
+    cli();
+
+    for (byte i=0; i < ports; i++) {
+        uint8_t mask = port[i].mask;
+
+        port[i].ddrSaved = *port[i].ddr & mask;
+        port[i].outSaved = *port[i].out & mask;
+
+        *port[i].ddr &= ~mask | port[i].ddrScan;
+        *port[i].out = (*port[i].out & ~mask) | port[i].outScan;
+        *port[i].ddr |= port[i].ddrScan;
+    }
+
+    SREG = sreg;
+}
+
+void KeySharedPins::release() {
+    uint8_t sreg = SREG;
+    cli();
+
+    for (byte i=0; i < ports; i++) {
+        uint8_t mask = port[i].mask;
+
+        *port[i].ddr &= ~mask | port[i].ddrSaved;
+        *port[i].out = (*port[i].out & ~mask) | port[i].outSaved;
+        *port[i].ddr |= port[i].ddrSaved;
+    }
+
+    SREG = sreg;
+}
+
+// A pin's mode and level while scanning, or as saved by the last claim().
+bool KeySharedPins::state(byte pin, bool scanning, byte &mode, byte &level) const {
+    volatile uint8_t *ddr = portModeRegister(digitalPinToPort(pin));
+    uint8_t bit = digitalPinToBitMask(pin);
+
+    for (byte i=0; i < ports; i++) {
+        if (port[i].ddr != ddr || !(port[i].mask & bit))
+            continue;
+
+        bool output = (scanning ? port[i].ddrScan : port[i].ddrSaved) & bit;
+        level = (scanning ? port[i].outScan : port[i].outSaved) & bit ? HIGH : LOW;
+        mode = output ? OUTPUT : level ? INPUT_PULLUP : INPUT;
+        return true;
+    }
+
+    return false;
+}
+
+#else
+
+bool KeySharedPins::build(const byte *, byte, const byte *, byte, bool) {
+    ports = 0;
+    return false;
+}
+
+void KeySharedPins::claim() {}
+void KeySharedPins::release() {}
+
+bool KeySharedPins::state(byte, bool, byte &, byte &) const {
+    return false;
+}
+
+#endif
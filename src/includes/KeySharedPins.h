@@ -0,0 +1,47 @@
+#ifndef KEYSHAREDPINS_H
+#define KEYSHAREDPINS_H
+
+// Arduino versioning.
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define KEYPAD_SHARED_PORTS 4		// Distinct I/O ports the matrix pins may span.
+
+// Saves, reconfigures and restores matrix pins that are shared with another
+// peripheral, such as the data bus of an HD44780 LCD. The pins are grouped by
+// port, so a claim or release costs three register writes per port however many
+// pins there are.
+//
+// AVR only: other cores have no portable way to read back a pin's mode, so there
+// is nothing to restore it from. There build() returns false.
+class KeySharedPins {
+public:
+    KeySharedPins(): ports(0) {}
+
+    bool build(const byte *rowPins, byte rows, const byte *colPins, byte cols, bool lowPower);
+    void claim();
+    void release();
+    bool state(byte pin, bool scanning, byte &mode, byte &level) const;
+    byte size() const { return ports; }
+
+private:
+    byte ports;
+#if defined(__AVR__)
+    struct {
+        volatile uint8_t *ddr;
+        volatile uint8_t *out;
+        uint8_t mask;			// Matrix pins on this port.
+        uint8_t ddrScan;		// Their configuration while scanning.
+        uint8_t outScan;
+        uint8_t ddrSaved;		// Their configuration before claim().
+        uint8_t outSaved;
+    } port[KEYPAD_SHARED_PORTS];
+
+    bool addPin(byte pin, bool output, bool level);
+#endif
+};
+
+#endif
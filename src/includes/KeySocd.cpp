@@ -0,0 +1,40 @@
+#include "KeySocd.h"
+
+#define SOCD_FIRST_CLOSED 0x01
+#define SOCD_SECOND_CLOSED 0x02
+#define SOCD_WINNER_SHIFT 2		// 0 none, 1 first, 2 second
+
+void keypadResolveSocd(KeypadSocdRule *rules, byte count, uint *bitMap, byte columns) {
+    for (byte i=0; i < count; i++) {
+        KeypadSocdRule &rule = rules[i];
+        byte firstRow = rule.first / columns, firstCol = rule.first % columns;
+        byte secondRow = rule.second / columns, secondCol = rule.second % columns;
+
+        bool first = bitRead(bitMap[firstRow], firstCol);
+        bool second = bitRead(bitMap[secondRow], secondCol);
+        bool wasFirst = rule.state & SOCD_FIRST_CLOSED;
+        bool wasSecond = rule.state & SOCD_SECOND_CLOSED;
+        byte winner = rule.state >> SOCD_WINNER_SHIFT;
+
+        if (first && second) {
+            // Which one arrived this frame decides last/first wins. Both at once is neutral.
+            bool newFirst = !wasFirst, newSecond = !wasSecond;
+
+            if (rule.mode == KEYPAD_SOCD_NEUTRAL || (newFirst && newSecond))
+                winner = 0;
+            else if (newFirst)
+                winner = rule.mode == KEYPAD_SOCD_LAST_WINS ? 1 : 2;
+            else if (newSecond)
+                winner = rule.mode == KEYPAD_SOCD_LAST_WINS ? 2 : 1;
+
+            if (winner != 1)
+                bitClear(bitMap[firstRow], firstCol);
+            if (winner != 2)
+                bitClear(bitMap[secondRow], secondCol);
+        } else {
+            winner = first ? 1 : second ? 2 : 0;
+        }
+
+        rule.state = (first ? SOCD_FIRST_CLOSED : 0) | (second ? SOCD_SECOND_CLOSED : 0) | (winner << SOCD_WINNER_SHIFT);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef KEYSOCD_H
+#define KEYSOCD_H
+
+// Arduino versioning.
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+typedef unsigned int uint;
+
+// How to resolve two opposing keys (left+right, up+down) held at the same time.
+typedef enum {
+    KEYPAD_SOCD_LAST_WINS,		// The key pressed most recently wins.
+    KEYPAD_SOCD_NEUTRAL,		// Neither key counts as pressed.
+    KEYPAD_SOCD_FIRST_WINS		// The key that was held first wins.
+} KeypadSocdMode;
+
+typedef struct {
+    byte first;		// Key codes of the pair.
+    byte second;
+    byte mode;		// KeypadSocdMode
+    byte state;		// Managed by keypadResolveSocd(), start at 0.
+} KeypadSocdRule;
+
+#define KEYPAD_SOCD_RULE(first, second, mode) { first, second, mode, 0 }
+
+// Clears the losing key of every rule in a row-word bitmap (one word per row, one
+// bit per column), before the state machine sees it.
+void keypadResolveSocd(KeypadSocdRule *rules, byte count, uint *bitMap, byte columns);
+
+#endif